@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_BITS_SYSARGS_H
+#define MOSNIX_BITS_SYSARGS_H
+
+#include <sys/types.h>
+
+/* Generated automatically */
+
+struct sys_read_s {
+    int fd;
+    void *data;
+    size_t size;
+};
+
+struct sys_write_s {
+    int fd;
+    const void *data;
+    size_t size;
+};
+
+struct sys_open_s {
+    const char *path;
+    int flags;
+    unsigned int mode;
+};
+
+struct sys_close_s {
+    int fd;
+};
+
+struct sys_lseek_s {
+    int fd;
+    off_t offset;
+    int whence;
+    off_t *result;
+};
+
+struct sys_fcntl_s {
+    int fd;
+    int cmd;
+    int value;
+};
+
+struct sys_dup_s {
+    int oldfd;
+};
+
+struct sys_dup2_s {
+    int oldfd;
+    int newfd;
+};
+
+struct sys_ioctl_s {
+    int fd;
+    int request;
+    void *arg;
+};
+
+struct sys_getcwd_s {
+    char *buf;
+    size_t size;
+    char* *result;
+};
+
+struct sys_chdir_s {
+    const char *path;
+};
+
+struct sys_mkdir_s {
+    const char *path;
+    mode_t mode;
+};
+
+struct sys_rmdir_s {
+    const char *path;
+};
+
+struct sys_mknod_s {
+    const char *path;
+    mode_t mode;
+    dev_t dev;
+};
+
+struct sys_unlink_s {
+    const char *path;
+};
+
+struct sys_stat_s {
+    const char *path;
+    struct stat *statbuf;
+};
+
+struct sys_lstat_s {
+    const char *path;
+    struct stat *statbuf;
+};
+
+struct sys_opendir_s {
+    const char *path;
+};
+
+struct sys_umask_s {
+    mode_t mask;
+};
+
+struct sys_mount_s {
+    const char *source;
+    const char *target;
+    const char *filesystemtype;
+    unsigned long mountflags;
+    const void *data;
+};
+
+struct sys_umount_s {
+    const char *target;
+};
+
+struct sys_exit_s {
+    int status;
+};
+
+struct sys_getpriority_s {
+    int which;
+    id_t who;
+};
+
+struct sys_setpriority_s {
+    int which;
+    id_t who;
+    int prio;
+};
+
+struct sys_setuid_s {
+    uid_t uid;
+};
+
+struct sys_seteuid_s {
+    uid_t uid;
+};
+
+struct sys_setgid_s {
+    gid_t gid;
+};
+
+struct sys_setegid_s {
+    gid_t gid;
+};
+
+struct sys_getmonotime_s {
+    long long *t;
+};
+
+struct sys_getrealtime_s {
+    long long *t;
+};
+
+struct sys_setrealtime_s {
+    long long t;
+};
+
+struct sys_nanosleep_s {
+    const struct timespec *req;
+    struct timespec *rem;
+};
+
+struct sys_alarm_s {
+    unsigned int seconds;
+};
+
+struct sys_getuname_s {
+    const struct utsname **buf;
+};
+
+struct sys_strerror_s {
+    int errnum;
+    char* *result;
+};
+
+struct sys_batch_s {
+    struct syscall_op *ops;
+    int count;
+    int flags;
+};
+
+struct sys_meminfo_s {
+    struct meminfo *info;
+};
+
+
+#endif
@@ -19,6 +19,7 @@
 #define SYS_fcntl 5
 #define SYS_dup 6
 #define SYS_dup2 7
+#define SYS_ioctl 8
 #define SYS_getcwd 20
 #define SYS_chdir 21
 #define SYS_mkdir 22
@@ -35,6 +36,8 @@
 #define SYS_getppid 51
 #define SYS_exit 52
 #define SYS_sched_yield 53
+#define SYS_getpriority 54
+#define SYS_setpriority 55
 #define SYS_getuid 60
 #define SYS_geteuid 61
 #define SYS_setuid 62
@@ -46,7 +49,11 @@
 #define SYS_getmonotime 80
 #define SYS_getrealtime 81
 #define SYS_setrealtime 82
+#define SYS_nanosleep 83
+#define SYS_alarm 84
 #define SYS_getuname 100
 #define SYS_strerror 101
+#define SYS_batch 102
+#define SYS_meminfo 103
 
 #endif
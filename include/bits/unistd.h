@@ -28,8 +28,8 @@ extern int chdir(const char *path);
 extern int rmdir(const char *path);
 extern int mknod(const char *path, mode_t mode, dev_t dev);
 extern int unlink(const char *path);
-extern pid_t getpid(void);
-extern pid_t getppid(void);
+extern pid_t _getpid(void);
+extern pid_t _getppid(void);
 extern void _exit(int status);
 extern uid_t getuid(void);
 extern uid_t geteuid(void);
@@ -39,6 +39,7 @@ extern gid_t getgid(void);
 extern gid_t getegid(void);
 extern int setgid(gid_t gid);
 extern int setegid(gid_t gid);
+extern unsigned int alarm(unsigned int seconds);
 
 #ifdef __cplusplus
 }
@@ -52,13 +52,56 @@
 #define CONFIG_ARGC_MAX 64
 #endif
 
+/**
+ * @def CONFIG_STACK_PARTITION
+ * @brief Define to 1 to give each process slot a fixed partition of the
+ * 0x0100 page for its 6502 return address stack.
+ *
+ * By default, all processes share the same region of the 0x0100 page and
+ * the contents are copied in and out of the process block on every
+ * context switch.  With partitioning, a context switch only needs to
+ * change the stack pointer, and the process block is smaller.  However,
+ * each process gets a smaller stack.
+ *
+ * A process and the kernel code that runs on its behalf must never use
+ * more than CONFIG_RETURN_STACK_SIZE bytes of return stack, which is 37
+ * bytes or about 18 nested calls with the default of 6 processes.
+ * Nothing stops a process from going deeper, and if it does then it
+ * silently overwrites the stack of the process in the partition below.
+ * Enable CONFIG_STACK_CHECK to detect this when debugging.
+ */
+#ifndef CONFIG_STACK_PARTITION
+#define CONFIG_STACK_PARTITION 0
+#endif
+
 /**
  * @brief Number of bytes of the 0x0100 page to allocate to each user
  * process as its 6502 return address stack.
+ *
+ * If CONFIG_STACK_PARTITION is 1, then there must be room for
+ * CONFIG_PROC_MAX stacks of this size in the page, with 32 bytes
+ * left over for the kernel's startup code.
  */
 #ifndef CONFIG_RETURN_STACK_SIZE
+#if CONFIG_STACK_PARTITION
+#define CONFIG_RETURN_STACK_SIZE (224 / CONFIG_PROC_MAX)
+#else
 #define CONFIG_RETURN_STACK_SIZE 64
 #endif
+#endif
+
+/**
+ * @def CONFIG_STACK_CHECK
+ * @brief Define to 1 to check on every context switch that the process
+ * being switched to is within its 6502 return stack allocation.
+ *
+ * If the process has overrun its stack, then the kernel reports the
+ * process identifier and halts.  The check is only able to catch
+ * overruns that are still in place when the process is switched out.
+ */
+#ifndef CONFIG_STACK_CHECK
+#define CONFIG_STACK_CHECK 0
+#endif
 
 /**
  * @brief Number of bytes of space to allocate to each user process
@@ -69,10 +112,132 @@
 #endif
 
 /**
- * @brief Number of buffers in the buffer cache.
+ * @brief Number of system ticks in a process's time slice before it is
+ * preempted to let other runnable processes have a turn.
+ *
+ * There are 256 system ticks per second.
+ */
+#ifndef CONFIG_SCHED_TIME_SLICE
+#define CONFIG_SCHED_TIME_SLICE 8
+#endif
+
+/**
+ * @brief Number of scheduling priority levels, between 1 and 8.
+ *
+ * The nice values from -20 to 19 are divided evenly between the levels.
+ * Processes at a higher priority level always run before processes at
+ * a lower level.  Processes at the same level take turns.
+ */
+#ifndef CONFIG_SCHED_LEVELS
+#define CONFIG_SCHED_LEVELS 4
+#endif
+
+/**
+ * @brief Number of bytes in the console's transmit ring buffer.
+ *
+ * Must be a power of two between 2 and 256.  Processes that write to
+ * the console copy their data into the ring and only block when it
+ * is full.  The ring is drained by the target's transmit interrupt.
+ */
+#ifndef CONFIG_TTY_TX_RING_SIZE
+#define CONFIG_TTY_TX_RING_SIZE 64
+#endif
+
+/**
+ * @brief Maximum number of bytes in a line of console input in canonical
+ * mode, including the terminating newline.  Must be between 2 and 255.
+ */
+#ifndef CONFIG_TTY_LINE_MAX
+#define CONFIG_TTY_LINE_MAX 80
+#endif
+
+/**
+ * @brief Number of slots in the kernel's timer wheel.
+ *
+ * Must be a power of two between 1 and 128.  More slots means fewer
+ * timers to check on each system tick, at the cost of 2 bytes per slot.
+ */
+#ifndef CONFIG_TIMER_WHEEL_SIZE
+#define CONFIG_TIMER_WHEEL_SIZE 8
+#endif
+
+/**
+ * @brief Number of buffers in the general-purpose buffer cache.
+ *
+ * The buffer cache is also used for inodes and filesystem objects
+ * when their own pools have been exhausted.
  */
 #ifndef CONFIG_NUM_BUFFERS
-#define CONFIG_NUM_BUFFERS 100
+#define CONFIG_NUM_BUFFERS 20
+#endif
+
+/**
+ * @brief Number of inodes in the inode pool, between 1 and 255.
+ */
+#ifndef CONFIG_NUM_INODES
+#define CONFIG_NUM_INODES 28
+#endif
+
+/**
+ * @brief Number of directory entries in the RAM filesystem's pool,
+ * between 1 and 255.
+ */
+#ifndef CONFIG_NUM_RAMFS_DIRENTS
+#define CONFIG_NUM_RAMFS_DIRENTS 32
+#endif
+
+/**
+ * @brief Number of inode and open file information blocks in the FAT
+ * filesystem's pool, between 1 and 255.
+ */
+#ifndef CONFIG_NUM_FATFS_INFO
+#define CONFIG_NUM_FATFS_INFO 12
+#endif
+
+/**
+ * @brief Number of 512-byte blocks in the SD card's block cache.
+ *
+ * The cache blocks are allocated from user space RAM when the SD card
+ * driver is initialized.  Blocks are replaced in least recently used order.
+ */
+#ifndef CONFIG_SD_CACHE_BLOCKS
+#define CONFIG_SD_CACHE_BLOCKS 3
+#endif
+
+/**
+ * @brief Number of 512-byte blocks in the SD card's FAT sector cache.
+ *
+ * FAT sectors are cached separately to file and directory data so that
+ * following a cluster chain does not evict the data being read.  Each
+ * FAT sector holds the entries for 128 clusters.
+ */
+#ifndef CONFIG_SD_FAT_CACHE_BLOCKS
+#define CONFIG_SD_FAT_CACHE_BLOCKS 1
+#endif
+
+/**
+ * @brief Maximum number of blocks to read ahead into the SD card's block
+ * cache when reading sequentially through a file or directory.
+ *
+ * Blocks that are read ahead replace the least recently used blocks in
+ * the cache.  This must be less than CONFIG_SD_CACHE_BLOCKS so that the
+ * block that is being read is never replaced.
+ */
+#ifndef CONFIG_SD_READ_AHEAD
+#define CONFIG_SD_READ_AHEAD 1
+#endif
+
+/**
+ * @brief Maximum number of extents in the cluster map for an open FAT file.
+ *
+ * When a file on the SD card is opened, the cluster chain is converted
+ * into a list of contiguous runs of clusters so that reading the file
+ * does not need to consult the FAT.  Files with more fragments than this
+ * fall back to following the cluster chain.  Each extent uses 6 bytes of
+ * user space RAM while the file is in use.
+ */
+#ifndef CONFIG_FATFS_MAX_EXTENTS
+#define CONFIG_FATFS_MAX_EXTENTS 8
 #endif
 
 /**
@@ -86,6 +86,20 @@ struct file_operations
      */
     ssize_t (*write)(struct file *file, const void *data, size_t len);
 
+    /**
+     * @brief Performs a device-specific control request.
+     *
+     * @param[in] file The file descriptor to control.
+     * @param[in] request The request code; e.g. TCGETS.
+     * @param[in,out] arg Argument for the request.
+     *
+     * @return Zero or a positive result on success, or a negative
+     * error code.
+     *
+     * This may be NULL if the file does not support any requests.
+     */
+    int (*ioctl)(struct file *file, int request, void *arg);
+
 #if CONFIG_LSEEK
     /**
      * @brief Seeks within a file.
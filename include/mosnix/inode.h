@@ -26,8 +26,8 @@ struct file;
  * @brief Structure of an inode in a filesystem.  This is the in-memory
  * representation of the inode data while it is being operated on.
  *
- * The inodes are allocated from the buffer cache, so there can be a
- * large number of them active at once.
+ * The inodes are allocated from a pool, so there can be a large number
+ * of them active at once.
  */
 struct inode
 {
@@ -164,20 +164,37 @@ struct inode_operations
 #endif
 };
 
-/* Check that the inode structure fits within a buffer cache entry */
-kmalloc_buf_size_check(inode);
+/**
+ * @brief Pool that inodes are allocated from.
+ */
+extern struct kmalloc_pool inode_pool;
 
 /**
- * @brief Allocates memory from the buffer cache for an inode.
+ * @brief Allocates memory from the inode pool for an inode.
  *
  * @param[in] operations Points to the operations table for the inode type.
  *
- * @return A pointer to the new inode, or NULL if out of buffer cache memory.
+ * @return A pointer to the new inode, or NULL if out of inode memory.
  *
- * The reference count of the new inode will be 1.
+ * The reference count of the new inode will be 1, and all other
+ * fields will be zero.
  */
 struct inode *inode_alloc(const struct inode_operations *operations);
 
+/**
+ * @brief Allocates memory from the inode pool for an inode without
+ * clearing it.
+ *
+ * @param[in] operations Points to the operations table for the inode type.
+ *
+ * @return A pointer to the new inode, or NULL if out of inode memory.
+ *
+ * The reference count of the new inode will be 1.  The caller must
+ * initialize all other fields of the inode, including the ownership
+ * fields if CONFIG_ACCESS_UID is enabled.
+ */
+struct inode *inode_alloc_raw(const struct inode_operations *operations);
+
 /**
  * @brief Adds another reference to an inode.
  *
@@ -9,7 +9,10 @@
 #ifndef MOSNIX_KMALLOC_H
 #define MOSNIX_KMALLOC_H
 
+#include <mosnix/attributes.h>
 #include <sys/types.h>
+#include <sys/meminfo.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,8 +23,11 @@ extern "C" {
  * inodes, RAM filesystem data, and other housekeeping values.
  *
  * All buffers are of the same size to make memory housekeeping simpler.
+ * Hosted builds for benchmarking override this because pointers are larger.
  */
+#ifndef KMALLOC_BUF_SIZE
 #define KMALLOC_BUF_SIZE 18
+#endif
 
 /**
  * @brief Initializes the kernel memory allocation system.
@@ -38,6 +44,18 @@ void kmalloc_init(void);
  */
 void *kmalloc_buf_alloc(void);
 
+/**
+ * @brief Allocates a buffer from the kernel's buffer cache without
+ * clearing it.
+ *
+ * @return The new buffer of exactly KMALLOC_BUF_SIZE bytes in length,
+ * or NULL if the buffer cache has been exhausted.
+ *
+ * The contents of the returned buffer are undefined.  This is useful
+ * when the caller is about to overwrite all of the buffer anyway.
+ */
+void *kmalloc_buf_alloc_raw(void);
+
 /**
  * @brief Frees a buffer back to the kernel's buffer cache.
  *
@@ -57,6 +75,136 @@ void kmalloc_buf_free(void *buf);
     typedef char type##_buf_size_check \
         [(sizeof(struct type) <= KMALLOC_BUF_SIZE) * 2 - 1]
 
+/**
+ * @brief Pool of kernel objects of a single type.
+ *
+ * Each object type that the kernel allocates often has its own pool,
+ * sized from the structure for the type.  This avoids wasting space on
+ * objects that are smaller than a buffer cache entry, and stops a burst
+ * of one type of object from using up the memory for all the others.
+ *
+ * Pools are defined with KMALLOC_POOL() and need no run-time
+ * initialization.  Objects are handed out from the storage area in order
+ * the first time, and then from the free list once they are recycled.
+ */
+struct kmalloc_pool
+{
+    /** List of objects that have been freed back to the pool */
+    void *free_list;
+
+    /** Next object in the storage area that has never been allocated */
+    char *next;
+
+    /** Start of the storage area for the pool */
+    char *start;
+
+    /** End of the storage area for the pool */
+    char *end;
+
+    /** Size of each object in bytes */
+    uint8_t size;
+
+    /** Non-zero if objects can be allocated from the buffer cache
+     *  when the pool is exhausted */
+    uint8_t fallback;
+
+    /** Maximum number of objects in the pool */
+    uint8_t limit;
+
+    /** Number of objects in the pool that are free */
+    uint8_t free;
+
+    /** Lowest number of free objects that the pool has had */
+    uint8_t low;
+
+    /** Number of allocations that failed because the pool and the
+     *  buffer cache fallback were both exhausted */
+    uint16_t failed;
+};
+
+/**
+ * @brief Defines a pool of kernel objects of a single type.
+ *
+ * @param[in] name The name of the pool variable.
+ * @param[in] type The name of the object type, without the "struct".
+ * @param[in] count The number of objects in the pool, between 1 and 255.
+ *
+ * If the type fits within a buffer cache entry, then objects will be
+ * allocated from the buffer cache once the pool is exhausted.
+ */
+#define KMALLOC_POOL(name, type, count) \
+    typedef char name##_count_check[((count) > 0 && (count) <= 255) * 2 - 1]; \
+    static union { \
+        struct type obj; \
+        void *next; \
+    } name##_storage[(count)] ATTR_SECTION_NOINIT; \
+    struct kmalloc_pool name = { \
+        .free_list = 0, \
+        .next = (char *)(name##_storage), \
+        .start = (char *)(name##_storage), \
+        .end = (char *)((name##_storage) + (count)), \
+        .size = sizeof((name##_storage)[0]), \
+        .fallback = (sizeof((name##_storage)[0]) <= KMALLOC_BUF_SIZE), \
+        .limit = (count), \
+        .free = (count), \
+        .low = (count), \
+        .failed = 0 \
+    }
+
+/**
+ * @brief Allocates an object from a pool.
+ *
+ * @param[in,out] pool The pool to allocate from.
+ *
+ * @return The new object, or NULL if the pool has been exhausted.
+ *
+ * The returned object will be initialized to all-zeroes.
+ */
+void *kmalloc_pool_alloc(struct kmalloc_pool *pool);
+
+/**
+ * @brief Allocates an object from a pool without clearing it.
+ *
+ * @param[in,out] pool The pool to allocate from.
+ *
+ * @return The new object, or NULL if the pool has been exhausted.
+ *
+ * The contents of the returned object are undefined.  This is useful
+ * when the caller is about to overwrite all of the fields anyway.
+ */
+void *kmalloc_pool_alloc_raw(struct kmalloc_pool *pool);
+
+/**
+ * @brief Frees an object back to the pool that it was allocated from.
+ *
+ * @param[in,out] pool The pool that the object was allocated from.
+ * @param[in] obj Points to the object to free.
+ */
+void kmalloc_pool_free(struct kmalloc_pool *pool, void *obj);
+
+/**
+ * @brief Gets usage information for the general-purpose buffer cache.
+ *
+ * @param[out] info Returns the usage information, except for the name.
+ */
+void kmalloc_buf_info(struct meminfo_pool *info);
+
+/**
+ * @brief Gets usage information for a pool.
+ *
+ * @param[in] pool The pool.
+ * @param[out] info Returns the usage information, except for the name.
+ */
+void kmalloc_pool_info(const struct kmalloc_pool *pool,
+                       struct meminfo_pool *info);
+
+/**
+ * @brief Gets usage information for user space memory.
+ *
+ * @param[out] info Returns the usage information in the "user_" fields.
+ */
+void kmalloc_user_info(struct meminfo *info);
+
 /**
  * @brief Allocates data in user space.
  *
@@ -64,6 +212,9 @@ void kmalloc_buf_free(void *buf);
  *
  * @return A pointer into user space, or NULL if there is insufficient
  * memory available.
+ *
+ * Large allocations such as program images are placed towards the end of
+ * user space and small allocations towards the start.
  */
 void *kmalloc_user_alloc(size_t size);
 
@@ -12,6 +12,7 @@
 #include <mosnix/attributes.h>
 #include <mosnix/config.h>
 #include <mosnix/sem.h>
+#include <mosnix/timer.h>
 #include <sys/types.h>
 #include <stdint.h>
 
@@ -101,8 +102,10 @@ struct proc_context
     /** A:X value to pass to the process upon a context switch */
     int AX;
 
+#if !CONFIG_STACK_PARTITION
     /** Saved locations from the 6502 return stack when context-switching */
     uint8_t stack[CONFIG_RETURN_STACK_SIZE];
+#endif
 
     /** Top of the per-process kernel data stack to use in system calls */
     uint8_t *kstack;
@@ -130,12 +133,26 @@ struct proc
     /** Current process state */
     enum proc_state state;
 
+    /** Current scheduling priority level, 0 is the highest.  This may be
+     *  temporarily different from "base_priority" due to a boost. */
+    uint8_t priority;
+
+    /** Scheduling priority level that corresponds to "nice" */
+    uint8_t base_priority;
+
+    /** Nice value for the process, between -20 and 19 */
+    int8_t nice;
+
     /** Queue next and previous pointers */
     TAILQ_ENTRY(proc) qptrs;
 
     /** Semaphore this process is waiting on, or NULL. */
     struct sem *wait_sem;
 
+    /** Timer for alarm(), which interrupts the process's wait when
+     *  it expires. */
+    struct timer alarm;
+
     /** Address in the zero page of the process's registers. */
     uint8_t *zp;
 
@@ -184,6 +201,14 @@ typedef int (*proc_internal_func_t)(int argc, char **argv);
  */
 extern struct proc * volatile current_proc ATTR_SECTION_ZP;
 
+/**
+ * @brief Address of the zero page area for the current process.
+ *
+ * This is used to fetch the arguments of register-based system calls
+ * from the process's RC2..RC5 registers.
+ */
+extern uint8_t volatile current_zp ATTR_SECTION_ZP;
+
 /**
  * @brief Non-zero if we are in the kernel and pre-emption should be
  * blocked until we are ready to return to user space.
@@ -207,6 +232,15 @@ void proc_init(void);
  */
 int proc_create(pid_t ppid, int argc, char **argv, struct proc **proc);
 
+/**
+ * @brief Finds a process given its process identifier.
+ *
+ * @param[in] pid The process identifier, or 0 for the current process.
+ *
+ * @return A pointer to the process, or NULL if @a pid does not exist.
+ */
+struct proc *proc_find(pid_t pid);
+
 /**
  * @brief Frees a process.
  *
@@ -245,6 +279,18 @@ int proc_create_internal
  */
 void proc_start_shell(void);
 
+#if CONFIG_STACK_CHECK
+
+/**
+ * @brief Checks that a process is within its 6502 return stack allocation,
+ * and halts the system if it is not.
+ *
+ * @param[in] proc The process to check, which must not be running.
+ */
+void proc_check_stack(const struct proc *proc);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,18 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Non-zero if the current process has used up its time slice
+ * and should give up the CPU at the next opportunity.
+ */
+extern uint8_t volatile need_resched ATTR_SECTION_ZP;
+
+/**
+ * @brief Number of system ticks that are left in the time slice of
+ * the current process.
+ */
+extern uint8_t volatile sched_slice_left;
+
 /**
  * @brief Initialize the scheduler.
  */
@@ -48,6 +60,94 @@ void sched_remove_runnable(struct proc *proc);
  */
 int schedule(void);
 
+/**
+ * @brief Moves the current process to the end of the run queue and
+ * schedules the next process to run.
+ *
+ * This function returns when the current process gets its next turn.
+ */
+void sched_preempt(void);
+
+/**
+ * @brief Wakes up a sleeping process early.
+ *
+ * @param[in] proc The process to wake up.
+ * @param[in] result The result to return from the wait; e.g. -EINTR.
+ *
+ * If @a proc is waiting on a semaphore, then it is removed from the
+ * semaphore's list of waiters.  Nothing happens if @a proc is not asleep.
+ */
+void sched_wake(struct proc *proc, int result);
+
+/**
+ * @brief Performs any semaphore signals and timers that are pending from
+ * interrupts, and then preempts the current process if a reschedule
+ * was requested.
+ *
+ * This is called on the way out of system calls and interrupts.
+ * Unlike sched_preempt(), the current process keeps running if it
+ * is still the highest priority runnable process.
+ */
+void sched_resched(void);
+
+/**
+ * @brief Lowest scheduling priority level.
+ */
+#define SCHED_PRIORITY_LOWEST (CONFIG_SCHED_LEVELS - 1)
+
+/**
+ * @brief Converts a nice value into a scheduling priority level.
+ *
+ * @param[in] nice The nice value, between -20 and 19.
+ *
+ * @return The priority level, where 0 is the highest.
+ */
+uint8_t sched_nice_to_priority(int nice);
+
+/**
+ * @brief Changes the current priority level of a process, and moves it
+ * to the matching run queue if it is runnable.
+ *
+ * @param[in] proc The process.
+ * @param[in] priority The new priority level, where 0 is the highest.
+ *
+ * The base priority of the process is not changed.
+ */
+void sched_set_priority(struct proc *proc, uint8_t priority);
+
+/**
+ * @brief Gets the priority level for a process when it is boosted.
+ *
+ * @param[in] proc The process.
+ *
+ * @return One level above the base priority of @a proc.
+ */
+static inline uint8_t sched_boosted_priority(const struct proc *proc)
+{
+    uint8_t priority = proc->base_priority;
+    return priority > 0 ? priority - 1 : 0;
+}
+
+/**
+ * @brief Boosts a process one level above its base priority until the
+ * end of its next time slice.
+ *
+ * @param[in] proc The process.
+ *
+ * This is used for processes that have just received interactive input,
+ * so that they can respond quickly.
+ */
+void sched_boost(struct proc *proc);
+
+/**
+ * @brief Counts down the time slice of the current process, and requests
+ * a reschedule when it expires.
+ *
+ * This is called once for every system tick.  It is safe to call from
+ * an interrupt handler, and only destroys the A register.
+ */
+ATTR_LEAF void sched_tick(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,7 @@
 
 #include <sys/types.h>
 #include <sys/queue.h>
+#include <mosnix/attributes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,16 +27,43 @@ typedef u_char sem_value_t;
 
 /**
  * @brief Semaphore primitive.
+ *
+ * The "isr_queued" and "isr_next" fields are accessed by sem_signal_isr()
+ * in assembly code, so they must stay at offsets 1 and 2.
  */
 struct sem
 {
     /** Value of the semaphore */
     sem_value_t value;
 
+    /** Non-zero if the semaphore is on the list of pending ISR signals */
+    u_char isr_queued;
+
+    /** Next semaphore on the list of pending ISR signals */
+    struct sem *isr_next;
+
     /** List of processes that are currently waiting on the semaphore. */
     struct run_queue waiters;
 };
 
+/**
+ * @brief List of semaphores that have been signalled by interrupt
+ * service routines but which have not been processed yet.
+ *
+ * The list is processed by sem_isr_flush() the next time that the
+ * kernel is in a position to wake up processes.
+ */
+extern struct sem * volatile sem_isr_list ATTR_SECTION_ZP;
+
+/**
+ * @brief Static initializer for a semaphore.
+ *
+ * @param[in] name The name of the semaphore variable.
+ * @param[in] init_value The initial value of the semaphore.
+ */
+#define SEM_INITIALIZER(name, init_value) \
+    { (init_value), 0, NULL, TAILQ_HEAD_INITIALIZER((name).waiters) }
+
 /**
  * @brief Initializes a semaphore.
  *
@@ -78,9 +106,22 @@ void sem_signal_monitor(struct sem *sem);
  * waiting processes, then the value will not be incremented.
  *
  * This is the only function in this API that can be called from an
- * interruption service routine (ISR) context.
+ * interruption service routine (ISR) context.  The semaphore is added
+ * to "sem_isr_list" and the actual signal is performed by the next call
+ * to sem_isr_flush().  Multiple signals before the flush are combined.
+ *
+ * Interrupts must be disabled when this function is called.  It only
+ * destroys the A and Y registers, and reads the semaphore pointer
+ * from RC2:RC3.
  */
-__attribute__((interrupt, no_isr)) void sem_signal_isr(struct sem *sem);
+ATTR_LEAF void sem_signal_isr(struct sem *sem);
+
+/**
+ * @brief Performs the signals that are pending in "sem_isr_list".
+ *
+ * This must be called from kernel context with preemption blocked.
+ */
+void sem_isr_flush(void);
 
 /**
  * @brief Waits for a semaphore to become available and decrements it.
@@ -92,6 +133,20 @@ __attribute__((interrupt, no_isr)) void sem_signal_isr(struct sem *sem);
  */
 int sem_wait(struct sem *sem);
 
+/**
+ * @brief Waits for a semaphore that signals interactive input and
+ * decrements it.
+ *
+ * @param[in,out] sem The semaphore to wait on.
+ *
+ * @return 0 if the semaphore was acquired, or -EINTR if the operation
+ * was interrupted.
+ *
+ * If the process has to sleep, then it is given a priority boost when it
+ * wakes up so that it can respond to the input quickly.
+ */
+int sem_wait_interactive(struct sem *sem);
+
 /**
  * @brief Waits for a semaphore to become available and decrements it,
  * or give up after a timeout.
@@ -10,7 +10,9 @@
 #define MOSNIX_SYSCALL_H
 
 #include <sys/types.h>
+#include <sys/meminfo.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/utsname.h>
 
 #ifdef __cplusplus
@@ -19,160 +21,25 @@ extern "C" {
 
 /* Generated automatically */
 
+#ifndef SYS_ATTR
 #define SYS_ATTR extern __attribute__((interrupt, no_isr))
+#endif
 
-struct sys_read_s {
-    int fd;
-    void *data;
-    size_t size;
-};
-
-struct sys_write_s {
-    int fd;
-    const void *data;
-    size_t size;
-};
-
-struct sys_open_s {
-    const char *path;
-    int flags;
-    unsigned int mode;
-};
-
-struct sys_close_s {
-    int fd;
-};
-
-struct sys_lseek_s {
-    int fd;
-    off_t offset;
-    int whence;
-    off_t *result;
-};
-
-struct sys_fcntl_s {
-    int fd;
-    int cmd;
-    int value;
-};
-
-struct sys_dup_s {
-    int oldfd;
-};
-
-struct sys_dup2_s {
-    int oldfd;
-    int newfd;
-};
-
-struct sys_getcwd_s {
-    char *buf;
-    size_t size;
-    char* *result;
-};
-
-struct sys_chdir_s {
-    const char *path;
-};
-
-struct sys_mkdir_s {
-    const char *path;
-    mode_t mode;
-};
-
-struct sys_rmdir_s {
-    const char *path;
-};
-
-struct sys_mknod_s {
-    const char *path;
-    mode_t mode;
-    dev_t dev;
-};
-
-struct sys_unlink_s {
-    const char *path;
-};
-
-struct sys_stat_s {
-    const char *path;
-    struct stat *statbuf;
-};
-
-struct sys_lstat_s {
-    const char *path;
-    struct stat *statbuf;
-};
-
-struct sys_opendir_s {
-    const char *path;
-};
-
-struct sys_umask_s {
-    mode_t mask;
-};
-
-struct sys_mount_s {
-    const char *source;
-    const char *target;
-    const char *filesystemtype;
-    unsigned long mountflags;
-    const void *data;
-};
-
-struct sys_umount_s {
-    const char *target;
-};
-
-struct sys_exit_s {
-    int status;
-};
-
-struct sys_setuid_s {
-    uid_t uid;
-};
-
-struct sys_seteuid_s {
-    uid_t uid;
-};
-
-struct sys_setgid_s {
-    gid_t gid;
-};
-
-struct sys_setegid_s {
-    gid_t gid;
-};
-
-struct sys_getmonotime_s {
-    long long *t;
-};
-
-struct sys_getrealtime_s {
-    long long *t;
-};
-
-struct sys_setrealtime_s {
-    long long t;
-};
-
-struct sys_getuname_s {
-    const struct utsname **buf;
-};
-
-struct sys_strerror_s {
-    int errnum;
-    char* *result;
-};
-
-/*   0 */ SYS_ATTR int sys_read(struct sys_read_s *args);
-/*   1 */ SYS_ATTR int sys_write(struct sys_write_s *args);
+/*   0 */ SYS_ATTR int sys_read(int fd, void *data, size_t size);
+/*   0 */ SYS_ATTR int sys_read_args(struct sys_read_s *args);
+/*   1 */ SYS_ATTR int sys_write(int fd, const void *data, size_t size);
+/*   1 */ SYS_ATTR int sys_write_args(struct sys_write_s *args);
 /*   2 */ SYS_ATTR int sys_open(struct sys_open_s *args);
-/*   3 */ SYS_ATTR int sys_close(struct sys_close_s *args);
+/*   3 */ SYS_ATTR int sys_close(int fd);
+/*   3 */ SYS_ATTR int sys_close_args(struct sys_close_s *args);
 /*   4 */ SYS_ATTR int sys_lseek(struct sys_lseek_s *args);
 /*   5 */ SYS_ATTR int sys_fcntl(struct sys_fcntl_s *args);
-/*   6 */ SYS_ATTR int sys_dup(struct sys_dup_s *args);
-/*   7 */ SYS_ATTR int sys_dup2(struct sys_dup2_s *args);
+/*   6 */ SYS_ATTR int sys_dup(int oldfd);
+/*   6 */ SYS_ATTR int sys_dup_args(struct sys_dup_s *args);
+/*   7 */ SYS_ATTR int sys_dup2(int oldfd, int newfd);
+/*   7 */ SYS_ATTR int sys_dup2_args(struct sys_dup2_s *args);
+/*   8 */ SYS_ATTR int sys_ioctl(int fd, int request, void *arg);
+/*   8 */ SYS_ATTR int sys_ioctl_args(struct sys_ioctl_s *args);
 /*  20 */ SYS_ATTR int sys_getcwd(struct sys_getcwd_s *args);
 /*  21 */ SYS_ATTR int sys_chdir(struct sys_chdir_s *args);
 /*  22 */ SYS_ATTR int sys_mkdir(struct sys_mkdir_s *args);
@@ -182,13 +49,16 @@ struct sys_strerror_s {
 /*  30 */ SYS_ATTR int sys_stat(struct sys_stat_s *args);
 /*  31 */ SYS_ATTR int sys_lstat(struct sys_lstat_s *args);
 /*  32 */ SYS_ATTR int sys_opendir(struct sys_opendir_s *args);
-/*  33 */ SYS_ATTR int sys_umask(struct sys_umask_s *args);
+/*  33 */ SYS_ATTR int sys_umask(mode_t mask);
+/*  33 */ SYS_ATTR int sys_umask_args(struct sys_umask_s *args);
 /*  34 */ SYS_ATTR int sys_mount(struct sys_mount_s *args);
 /*  35 */ SYS_ATTR int sys_umount(struct sys_umount_s *args);
 /*  50 */ SYS_ATTR int sys_getpid(void);
 /*  51 */ SYS_ATTR int sys_getppid(void);
 /*  52 */ SYS_ATTR void sys_exit(struct sys_exit_s *args);
 /*  53 */ SYS_ATTR int sys_sched_yield(void);
+/*  54 */ SYS_ATTR int sys_getpriority(struct sys_getpriority_s *args);
+/*  55 */ SYS_ATTR int sys_setpriority(struct sys_setpriority_s *args);
 /*  60 */ SYS_ATTR int sys_getuid(void);
 /*  61 */ SYS_ATTR int sys_geteuid(void);
 /*  62 */ SYS_ATTR int sys_setuid(struct sys_setuid_s *args);
@@ -200,8 +70,15 @@ struct sys_strerror_s {
 /*  80 */ SYS_ATTR int sys_getmonotime(struct sys_getmonotime_s *args);
 /*  81 */ SYS_ATTR int sys_getrealtime(struct sys_getrealtime_s *args);
 /*  82 */ SYS_ATTR int sys_setrealtime(struct sys_setrealtime_s *args);
+/*  83 */ SYS_ATTR int sys_nanosleep(const struct timespec *req, struct timespec *rem);
+/*  83 */ SYS_ATTR int sys_nanosleep_args(struct sys_nanosleep_s *args);
+/*  84 */ SYS_ATTR int sys_alarm(unsigned int seconds);
+/*  84 */ SYS_ATTR int sys_alarm_args(struct sys_alarm_s *args);
 /* 100 */ SYS_ATTR int sys_getuname(struct sys_getuname_s *args);
 /* 101 */ SYS_ATTR int sys_strerror(struct sys_strerror_s *args);
+/* 102 */ SYS_ATTR int sys_batch(struct sys_batch_s *args);
+/* 103 */ SYS_ATTR int sys_meminfo(struct meminfo *info);
+/* 103 */ SYS_ATTR int sys_meminfo_args(struct sys_meminfo_s *args);
 /* N/A */ SYS_ATTR int sys_notimp(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_TIMER_H
+#define MOSNIX_TIMER_H
+
+#include <mosnix/attributes.h>
+#include <mosnix/config.h>
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of timer ticks per second.
+ */
+#define TIMER_HZ 256
+
+struct timer;
+
+/**
+ * @brief Function to call when a timer expires.
+ *
+ * @param[in] timer The timer that expired.
+ *
+ * The function is called from kernel context with preemption blocked,
+ * and it may start the timer again.
+ */
+typedef void (*timer_func_t)(struct timer *timer);
+
+/**
+ * @brief Timer in the kernel's timer wheel.
+ */
+struct timer
+{
+    /** Links to the other timers in the same slot of the wheel */
+    LIST_ENTRY(timer) link;
+
+    /** Value of the wheel's tick counter when the timer expires */
+    clock_t expires;
+
+    /** Function to call when the timer expires */
+    timer_func_t func;
+
+    /** Argument for the function; e.g. the process to wake up */
+    void *arg;
+};
+
+/**
+ * @brief Number of system ticks that have occurred and which have not
+ * yet been processed by timer_run().
+ *
+ * This is only incremented while "timer_active" is non-zero.
+ */
+extern uint8_t volatile timer_pending ATTR_SECTION_ZP;
+
+/**
+ * @brief Number of timers that are currently running.
+ */
+extern uint8_t volatile timer_active ATTR_SECTION_ZP;
+
+/**
+ * @brief Starts a timer.
+ *
+ * @param[out] timer The timer to start.  If the timer is already
+ * running, then it is stopped first.
+ * @param[in] ticks Number of system ticks until the timer expires,
+ * which must be at least 1.
+ * @param[in] func Function to call when the timer expires.
+ * @param[in] arg Argument for @a func.
+ */
+void timer_start(struct timer *timer, clock_t ticks,
+                 timer_func_t func, void *arg);
+
+/**
+ * @brief Stops a timer if it is running.
+ *
+ * @param[in,out] timer The timer to stop.
+ */
+void timer_stop(struct timer *timer);
+
+/**
+ * @brief Determines if a timer is running.
+ *
+ * @param[in] timer The timer.
+ *
+ * @return Non-zero if @a timer is running.
+ */
+static inline uint8_t timer_is_running(const struct timer *timer)
+{
+    return timer->link.le_prev != NULL;
+}
+
+/**
+ * @brief Gets the number of ticks until a timer expires.
+ *
+ * @param[in] timer The timer.
+ *
+ * @return The number of ticks, or zero if @a timer is not running.
+ */
+clock_t timer_remaining(const struct timer *timer);
+
+/**
+ * @brief Processes the pending system ticks and calls the functions
+ * for the timers that have expired.
+ *
+ * This must be called from kernel context with preemption blocked.
+ */
+void timer_run(void);
+
+/**
+ * @brief Puts the current process to sleep for a number of ticks.
+ *
+ * @param[in] ticks Number of system ticks to sleep for.
+ * @param[out] left Returns the number of ticks that were left if the
+ * sleep was interrupted.  May be NULL.
+ *
+ * @return Zero if the full time has elapsed, or -EINTR if interrupted.
+ */
+int timer_sleep(clock_t ticks, clock_t *left);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
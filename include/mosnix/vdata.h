@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_VDATA_H
+#define MOSNIX_VDATA_H
+
+/**
+ * @brief Address of the kernel data page, which user space can read
+ * to get information without performing a system call.
+ */
+#define VDATA_ADDR 0x0200
+
+/**
+ * @brief Number of bytes that are reserved for the kernel data page.
+ */
+#define VDATA_SIZE 32
+
+/* Addresses of fields that are used by assembly code.  These must be
+ * kept in sync with the layout of "struct vdata" below. */
+#define VDATA_SEQ   (VDATA_ADDR + 0)
+#define VDATA_TICKS (VDATA_ADDR + 6)
+
+/**
+ * @brief Flag that indicates that the "ticks" field of the kernel data
+ * page is kept up to date by the system tick interrupt.
+ *
+ * If this flag is not set, then the monotonic clock must be fetched with
+ * the "getmonotime" system call instead.
+ */
+#define VDATA_FLAG_TICKS 0x01
+
+#ifndef __ASSEMBLER__
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Layout of the kernel data page.
+ *
+ * The kernel increments "seq" whenever "ticks" or "realtime" changes.
+ * Readers should fetch "seq", then the fields, and then try again if
+ * "seq" has changed in the meantime.
+ */
+struct vdata
+{
+    /** Sequence number for detecting updates while reading */
+    uint8_t seq;
+
+    /** Flags that describe the contents of the page */
+    uint8_t flags;
+
+    /** Identifier of the current process */
+    pid_t pid;
+
+    /** Identifier of the parent of the current process */
+    pid_t ppid;
+
+    /** Monotonic time in 1/256'ths of a second since boot */
+    long long ticks;
+
+    /** Offset to add to the monotonic time to get the real time */
+    long long realtime;
+};
+
+/**
+ * @brief Points to the kernel data page.
+ */
+#define VDATA ((volatile struct vdata *)VDATA_ADDR)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__ASSEMBLER__ */
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_STDIO_EXT_H
+#define MOSNIX_STDIO_EXT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Standard output is line-buffered and standard error is unbuffered.
+ * Standard output is flushed when a newline is written, when the buffer
+ * is full, before getchar() reads from standard input, and at exit.
+ */
+
+/* Size of the buffer for standard output */
+#define STDOUT_BUFSIZ 64
+
+/* Flushes all line-buffered streams; i.e. standard output */
+void _flushlbf(void);
+
+/* Writes a block of characters to standard output through the buffer */
+void __putchars(const char *s, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
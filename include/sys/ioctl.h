@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_SYS_IOCTL_H
+#define MOSNIX_SYS_IOCTL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Terminal requests.  The TCSETS variants are in the same order as
+ * the actions for tcsetattr(). */
+#define TCGETS      0x5401
+#define TCSETS      0x5402
+#define TCSETSW     0x5403
+#define TCSETSF     0x5404
+
+int ioctl(int fd, int request, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_SYS_MEMINFO_H
+#define MOSNIX_SYS_MEMINFO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum length of a pool name, including the terminating NUL */
+#define MEMINFO_NAME_MAX 8
+
+/** Maximum number of kernel object pools that can be reported */
+#define MEMINFO_MAX_POOLS 6
+
+/**
+ * @brief Usage information for a pool of kernel objects.
+ */
+struct meminfo_pool
+{
+    /** Name of the pool */
+    char name[MEMINFO_NAME_MAX];
+
+    /** Size of each object in the pool in bytes */
+    unsigned short size;
+
+    /** Total number of objects in the pool */
+    unsigned short total;
+
+    /** Number of objects that are free */
+    unsigned short free;
+
+    /** Largest number of objects that have been in use at once */
+    unsigned short peak;
+
+    /** Number of allocations that have failed.  Allocations that the
+     *  pool satisfied from the general-purpose buffer cache instead are
+     *  not counted, but are included in the buffer cache's usage */
+    unsigned short failed;
+};
+
+/**
+ * @brief Memory usage information for the kernel and user space.
+ */
+struct meminfo
+{
+    /** Number of entries in "pools" that are valid */
+    unsigned short num_pools;
+
+    /** Usage information for the kernel's object pools, starting
+     *  with the general-purpose buffer cache */
+    struct meminfo_pool pools[MEMINFO_MAX_POOLS];
+
+    /** Total size of the user space memory region in bytes */
+    unsigned short user_total;
+
+    /** Number of bytes of user space memory that are free */
+    unsigned short user_free;
+
+    /** Largest number of bytes of user space memory in use at once */
+    unsigned short user_peak;
+
+    /** Size of the largest free block of user space memory in bytes */
+    unsigned short user_largest;
+
+    /** Number of free blocks in user space memory, which indicates
+     *  how fragmented it is */
+    unsigned short user_blocks;
+
+    /** Number of user space memory allocations that have failed */
+    unsigned short user_failed;
+};
+
+/**
+ * @brief Gets memory usage information from the kernel.
+ *
+ * @param[out] info Returns the memory usage information.
+ *
+ * @return Zero on success, or -1 on error with the error in errno.
+ */
+int meminfo(struct meminfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_SYS_RESOURCE_H
+#define MOSNIX_SYS_RESOURCE_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Values for "which" in getpriority() and setpriority() */
+#define PRIO_PROCESS    0
+#define PRIO_PGRP       1
+#define PRIO_USER       2
+
+/* Range of nice values */
+#define PRIO_MIN        (-20)
+#define PRIO_MAX        19
+
+int getpriority(int which, id_t who);
+int setpriority(int which, id_t who, int prio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,15 +10,38 @@
 #define MOSNIX_SYS_SYSCALL_H
 
 #include <bits/syscall.h>
+#include <bits/sysargs.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* One operation in a batch of system calls for syscall_batch().
+ * "args" points to the arguments, laid out in the same way as the
+ * "struct sys_*_s" for the system call in <bits/sysargs.h>. */
+struct syscall_op
+{
+    unsigned char number;
+    void *args;
+    int result;
+};
+
+/* Flag for syscall_batch() to stop at the first operation that fails */
+#define SYSCALL_BATCH_STOP 0x01
+
 /* Invoke a kernel system call.  If the result is negative,
  * then populate the "errno" variable and return -1. */
 __attribute__((leaf)) int syscall(unsigned char number, ...);
 
+/* Same as syscall(), but enters the kernel with the BRK trap instead
+ * of calling the system call vector. */
+__attribute__((leaf)) int syscall_brk(unsigned char number, ...);
+
+/* Invoke a batch of system calls with a single entry into the kernel.
+ * The result of each operation is written to its "result" field.
+ * Returns the number of operations that were performed. */
+int syscall_batch(struct syscall_op *ops, int count, int flags);
+
 #ifdef __cplusplus
 }
 #endif
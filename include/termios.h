@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_TERMIOS_H
+#define MOSNIX_TERMIOS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned short tcflag_t;
+typedef unsigned char cc_t;
+
+/* Indexes into c_cc.  VINTR, VMIN, and VTIME are currently ignored;
+ * non-canonical reads return once at least one byte is available. */
+#define VINTR       0
+#define VEOF        1
+#define VERASE      2
+#define VKILL       3
+#define VMIN        4
+#define VTIME       5
+#define NCCS        6
+
+/* Input mode flags for c_iflag */
+#define ICRNL       0x0001
+
+/* Output mode flags for c_oflag */
+#define OPOST       0x0001
+#define ONLCR       0x0002
+
+/* Local mode flags for c_lflag */
+#define ECHO        0x0001
+#define ECHOE       0x0002
+#define ECHOK       0x0004
+#define ECHONL      0x0008
+#define ICANON      0x0010
+
+/* Actions for tcsetattr() */
+#define TCSANOW     0
+#define TCSADRAIN   1
+#define TCSAFLUSH   2
+
+struct termios
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_cc[NCCS];
+};
+
+int tcgetattr(int fd, struct termios *t);
+int tcsetattr(int fd, int action, const struct termios *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
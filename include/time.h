@@ -21,6 +21,7 @@ extern "C" {
 time_t time(time_t *timep);
 int clock_gettime(clockid_t clockid, struct timespec *ts);
 int clock_settime(clockid_t clockid, struct timespec *ts);
+int nanosleep(const struct timespec *req, struct timespec *rem);
 
 extern char *tzname[2];
 extern long timezone;
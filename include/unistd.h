@@ -15,7 +15,7 @@
 #define F_OK 0
 #define X_OK 1
 #define W_OK 2
-#define R_OK 3
+#define R_OK 4
 
 /* Modes for lseek */
 #ifndef SEEK_SET
@@ -24,4 +24,11 @@
 #define SEEK_END 2
 #endif
 
+/* Gets the process identifiers of the current process and its parent */
+pid_t getpid(void);
+pid_t getppid(void);
+
+/* Adjusts the scheduling priority of the current process */
+int nice(int inc);
+
 #endif
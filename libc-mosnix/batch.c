@@ -8,7 +8,7 @@
 
 #include <sys/syscall.h>
 
-int sched_yield(void)
+int syscall_batch(struct syscall_op *ops, int count, int flags)
 {
-    return syscall(SYS_sched_yield);
+    return syscall(SYS_batch, ops, count, flags);
 }
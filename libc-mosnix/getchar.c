@@ -1,9 +1,11 @@
 
+#include <stdio_ext.h>
 #include <unistd.h>
 
 int getchar(void)
 {
     unsigned char c;
+    _flushlbf();
     if (read(0, &c, 1) < 1)
         return -1;
     else
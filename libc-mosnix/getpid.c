@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <unistd.h>
+#include <mosnix/vdata.h>
+
+/* The kernel keeps the process identifiers of the current process in
+ * the kernel data page, so there is no need for a system call. */
+
+pid_t getpid(void)
+{
+    return VDATA->pid;
+}
+
+pid_t getppid(void)
+{
+    return VDATA->ppid;
+}
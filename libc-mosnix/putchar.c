@@ -1,7 +1,53 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
 
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+static char stdout_buf[STDOUT_BUFSIZ];
+static unsigned char stdout_len;
+static unsigned char stdout_registered;
+
+void _flushlbf(void)
+{
+    if (stdout_len > 0) {
+        write(1, stdout_buf, stdout_len);
+        stdout_len = 0;
+    }
+}
+
+void __putchars(const char *s, size_t len)
+{
+    size_t space;
+    const char *nl = memchr(s, '\n', len);
+    if (!stdout_registered) {
+        /* Flush whatever is left in the buffer when the program exits */
+        atexit(_flushlbf);
+        stdout_registered = 1;
+    }
+    while (len > 0) {
+        space = STDOUT_BUFSIZ - stdout_len;
+        if (space > len)
+            space = len;
+        memcpy(stdout_buf + stdout_len, s, space);
+        stdout_len += (unsigned char)space;
+        s += space;
+        len -= space;
+        if (stdout_len >= STDOUT_BUFSIZ)
+            _flushlbf();
+    }
+    if (nl)
+        _flushlbf();
+}
+
 void __putchar(char c)
 {
-    write(1, &c, 1);
+    __putchars(&c, 1);
 }
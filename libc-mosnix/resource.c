@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* The kernel returns 20 - prio from getpriority() so that the result is
+ * always positive and cannot be confused with an error code. */
+
+int getpriority(int which, id_t who)
+{
+    int result = syscall(SYS_getpriority, which, who);
+    if (result < 0)
+        return -1;
+    return 20 - result;
+}
+
+int setpriority(int which, id_t who, int prio)
+{
+    return syscall(SYS_setpriority, which, who, prio);
+}
+
+int nice(int inc)
+{
+    int prio;
+    errno = 0;
+    prio = getpriority(PRIO_PROCESS, 0);
+    if (prio == -1 && errno != 0)
+        return -1;
+    prio += inc;
+    if (prio < PRIO_MIN)
+        prio = PRIO_MIN;
+    else if (prio > PRIO_MAX)
+        prio = PRIO_MAX;
+    if (setpriority(PRIO_PROCESS, 0, prio) < 0)
+        return -1;
+    return prio;
+}
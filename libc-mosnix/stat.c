@@ -18,8 +18,3 @@ int lstat(const char *path, struct stat *buf)
 {
     return syscall(SYS_lstat, path, buf);
 }
-
-mode_t umask(mode_t mask)
-{
-    return (mode_t)syscall(SYS_umask, mask);
-}
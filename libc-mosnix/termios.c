@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+
+int tcgetattr(int fd, struct termios *t)
+{
+    return ioctl(fd, TCGETS, t);
+}
+
+int tcsetattr(int fd, int action, const struct termios *t)
+{
+    if (action < TCSANOW || action > TCSAFLUSH) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ioctl(fd, TCSETS + action, (void *)t);
+}
@@ -10,18 +10,43 @@
 #include <stdint.h>
 #include <errno.h>
 #include <sys/syscall.h>
+#include <mosnix/vdata.h>
 
 /* The kernel provides a monotonic tick counter in 1/256's of a second.
  * The kernel also provides a real time tick "offset".  To get the current
  * real time, add the offset to the monotonic tick value. */
 
+/**
+ * @brief Gets the monotonic tick counter and the real time offset.
+ *
+ * The values are read from the kernel data page if the kernel keeps the
+ * tick counter there up to date.  Otherwise a system call is needed.
+ *
+ * @param[out] mono Returns the monotonic tick counter.
+ * @param[out] offset Returns the real time offset.
+ */
+static void time_get(long long *mono, long long *offset)
+{
+    unsigned char seq;
+    if (VDATA->flags & VDATA_FLAG_TICKS) {
+        /* Try again if the ticks changed while we were reading them */
+        do {
+            seq = VDATA->seq;
+            *mono = VDATA->ticks;
+            *offset = VDATA->realtime;
+        } while (seq != VDATA->seq);
+    } else {
+        syscall(SYS_getmonotime, mono);
+        *offset = VDATA->realtime;
+    }
+}
+
 time_t time(time_t *timep)
 {
     long long t1;
     long long t2;
     time_t t;
-    syscall(SYS_getmonotime, &t1);
-    syscall(SYS_getrealtime, &t2);
+    time_get(&t1, &t2);
     t = (time_t)((t1 + t2) >> 8);
     if (timep)
         *timep = t;
@@ -36,10 +61,9 @@ int clock_gettime(clockid_t clockid, struct timespec *ts)
         errno = EFAULT;
         return -1;
     } else if (clockid == CLOCK_MONOTONIC) {
-        syscall(SYS_getmonotime, &t1);
+        time_get(&t1, &t2);
     } else if (clockid == CLOCK_REALTIME) {
-        syscall(SYS_getmonotime, &t1);
-        syscall(SYS_getrealtime, &t2);
+        time_get(&t1, &t2);
         t1 += t2;
         if (t1 < 0)
             t1 = 0; /* Cannot go backwards past the epoch */
@@ -61,9 +85,10 @@ int clock_settime(clockid_t clockid, struct timespec *ts)
                ts->tv_sec >= 0 && ts->tv_nsec >= 0) {
         long long t1;
         long long t2;
+        long long t3;
         t2 = (((long long)(ts->tv_sec)) << 8);
         t2 += (((long long)(ts->tv_nsec)) << 8) / 1000000000LL;
-        syscall(SYS_getmonotime, &t1);
+        time_get(&t1, &t3);
         t2 -= t1;
         return syscall(SYS_setrealtime, t2);
     } else {
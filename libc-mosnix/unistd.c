@@ -11,21 +11,6 @@
 
 /* Generated automatically */
 
-ssize_t read(int fd, void *data, size_t size)
-{
-    return syscall(SYS_read, fd, data, size);
-}
-
-ssize_t write(int fd, const void *data, size_t size)
-{
-    return syscall(SYS_write, fd, data, size);
-}
-
-int close(int fd)
-{
-    return syscall(SYS_close, fd);
-}
-
 off_t lseek(int fd, off_t offset, int whence)
 {
     off_t result;
@@ -35,16 +20,6 @@ off_t lseek(int fd, off_t offset, int whence)
         return -1;
 }
 
-int dup(int oldfd)
-{
-    return syscall(SYS_dup, oldfd);
-}
-
-int dup2(int oldfd, int newfd)
-{
-    return syscall(SYS_dup2, oldfd, newfd);
-}
-
 char* getcwd(char *buf, size_t size)
 {
     char* result;
@@ -74,16 +49,6 @@ int unlink(const char *path)
     return syscall(SYS_unlink, path);
 }
 
-pid_t getpid(void)
-{
-    return syscall(SYS_getpid);
-}
-
-pid_t getppid(void)
-{
-    return syscall(SYS_getppid);
-}
-
 void _exit(int status)
 {
     syscall(SYS_exit, status);
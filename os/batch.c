@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <mosnix/syscall.h>
+#include <mosnix/sched.h>
+#include <errno.h>
+
+/* System call dispatch table from "dispatch.c" */
+extern void * const SYSCALL_TABLE[128];
+
+/* All entries in SYSCALL_TABLE take a pointer to their arguments */
+typedef int (*syscall_func_t)(void *args);
+
+int sys_batch(struct sys_batch_s *args)
+{
+    struct syscall_op *op = args->ops;
+    int count = args->count;
+    int done = 0;
+
+    /* Validate the parameters */
+    if (count < 0)
+        return -EINVAL;
+    if (!op && count > 0)
+        return -EFAULT;
+
+    /* Perform the operations in order */
+    while (done < count) {
+        if (op->number >= 128 || op->number == SYS_batch) {
+            /* Batches cannot be nested */
+            op->result = -ENOSYS;
+        } else {
+            op->result =
+                ((syscall_func_t)(SYSCALL_TABLE[op->number]))(op->args);
+        }
+        ++done;
+        if (op->result < 0 && (args->flags & SYSCALL_BATCH_STOP))
+            break;
+
+        /* Let other processes run if the time slice has expired */
+        if (need_resched)
+            sched_preempt();
+        ++op;
+    }
+    return done;
+}
@@ -159,9 +159,9 @@ int sys_opendir(struct sys_opendir_s *args)
     return file_open(args->path, O_RDONLY, S_IFDIR);
 }
 
-int sys_umask(struct sys_umask_s *args)
+int sys_umask(mode_t mask)
 {
     mode_t prev = current_proc->umask;
-    current_proc->umask = args->mask & 0777;
+    current_proc->umask = mask & 0777;
     return prev;
 }
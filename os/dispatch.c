@@ -10,16 +10,66 @@
 
 /* Generated automatically */
 
+int sys_read_args(struct sys_read_s *args)
+{
+    return sys_read(args->fd, args->data, args->size);
+}
+
+int sys_write_args(struct sys_write_s *args)
+{
+    return sys_write(args->fd, args->data, args->size);
+}
+
+int sys_close_args(struct sys_close_s *args)
+{
+    return sys_close(args->fd);
+}
+
+int sys_dup_args(struct sys_dup_s *args)
+{
+    return sys_dup(args->oldfd);
+}
+
+int sys_dup2_args(struct sys_dup2_s *args)
+{
+    return sys_dup2(args->oldfd, args->newfd);
+}
+
+int sys_ioctl_args(struct sys_ioctl_s *args)
+{
+    return sys_ioctl(args->fd, args->request, args->arg);
+}
+
+int sys_umask_args(struct sys_umask_s *args)
+{
+    return sys_umask(args->mask);
+}
+
+int sys_nanosleep_args(struct sys_nanosleep_s *args)
+{
+    return sys_nanosleep(args->req, args->rem);
+}
+
+int sys_alarm_args(struct sys_alarm_s *args)
+{
+    return sys_alarm(args->seconds);
+}
+
+int sys_meminfo_args(struct sys_meminfo_s *args)
+{
+    return sys_meminfo(args->info);
+}
+
 void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
-    /*   0 */ (void *)sys_read,
-    /*   1 */ (void *)sys_write,
+    /*   0 */ (void *)sys_read_args,
+    /*   1 */ (void *)sys_write_args,
     /*   2 */ (void *)sys_open,
-    /*   3 */ (void *)sys_close,
+    /*   3 */ (void *)sys_close_args,
     /*   4 */ (void *)sys_lseek,
     /*   5 */ (void *)sys_fcntl,
-    /*   6 */ (void *)sys_dup,
-    /*   7 */ (void *)sys_dup2,
-    /*   8 */ (void *)sys_notimp,
+    /*   6 */ (void *)sys_dup_args,
+    /*   7 */ (void *)sys_dup2_args,
+    /*   8 */ (void *)sys_ioctl_args,
     /*   9 */ (void *)sys_notimp,
     /*  10 */ (void *)sys_notimp,
     /*  11 */ (void *)sys_notimp,
@@ -44,7 +94,7 @@ void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
     /*  30 */ (void *)sys_stat,
     /*  31 */ (void *)sys_lstat,
     /*  32 */ (void *)sys_opendir,
-    /*  33 */ (void *)sys_umask,
+    /*  33 */ (void *)sys_umask_args,
     /*  34 */ (void *)sys_mount,
     /*  35 */ (void *)sys_umount,
     /*  36 */ (void *)sys_notimp,
@@ -65,8 +115,8 @@ void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
     /*  51 */ (void *)sys_getppid,
     /*  52 */ (void *)sys_exit,
     /*  53 */ (void *)sys_sched_yield,
-    /*  54 */ (void *)sys_notimp,
-    /*  55 */ (void *)sys_notimp,
+    /*  54 */ (void *)sys_getpriority,
+    /*  55 */ (void *)sys_setpriority,
     /*  56 */ (void *)sys_notimp,
     /*  57 */ (void *)sys_notimp,
     /*  58 */ (void *)sys_notimp,
@@ -94,8 +144,8 @@ void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
     /*  80 */ (void *)sys_getmonotime,
     /*  81 */ (void *)sys_getrealtime,
     /*  82 */ (void *)sys_setrealtime,
-    /*  83 */ (void *)sys_notimp,
-    /*  84 */ (void *)sys_notimp,
+    /*  83 */ (void *)sys_nanosleep_args,
+    /*  84 */ (void *)sys_alarm_args,
     /*  85 */ (void *)sys_notimp,
     /*  86 */ (void *)sys_notimp,
     /*  87 */ (void *)sys_notimp,
@@ -113,8 +163,8 @@ void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
     /*  99 */ (void *)sys_notimp,
     /* 100 */ (void *)sys_getuname,
     /* 101 */ (void *)sys_strerror,
-    /* 102 */ (void *)sys_notimp,
-    /* 103 */ (void *)sys_notimp,
+    /* 102 */ (void *)sys_batch,
+    /* 103 */ (void *)sys_meminfo_args,
     /* 104 */ (void *)sys_notimp,
     /* 105 */ (void *)sys_notimp,
     /* 106 */ (void *)sys_notimp,
@@ -140,3 +190,19 @@ void * const SYSCALL_TABLE[128] __attribute__((retain)) = {
     /* 126 */ (void *)sys_notimp,
     /* 127 */ (void *)sys_notimp
 };
+
+void * const SYSCALL_REG_TABLE[] __attribute__((retain)) = {
+    /*   0 */ (void *)sys_read,
+    /*   1 */ (void *)sys_write,
+    /*   2 */ (void *)sys_close,
+    /*   3 */ (void *)sys_dup,
+    /*   4 */ (void *)sys_dup2,
+    /*   5 */ (void *)sys_umask,
+    /*   6 */ (void *)sys_getpid,
+    /*   7 */ (void *)sys_getppid,
+    /*   8 */ (void *)sys_sched_yield,
+    /*   9 */ (void *)sys_ioctl,
+    /*  10 */ (void *)sys_nanosleep,
+    /*  11 */ (void *)sys_alarm,
+    /*  12 */ (void *)sys_meminfo,
+};
@@ -11,11 +11,18 @@
 #include <mosnix/config.h>
 #include <mosnix/target.h>
 #include <mosnix/attributes.h>
+#include <mosnix/kmalloc.h>
 #include <mosnix/printk.h>
+#include <mosnix/sem.h>
+#include <mosnix/timer.h>
 #include <string.h>
 
 #if defined(CONFIG_SD) && defined(CONFIG_SPI)
 
+#if CONFIG_SD_READ_AHEAD >= CONFIG_SD_CACHE_BLOCKS
+#error "Read-ahead would evict the block that is being read"
+#endif
+
 /* SD card commands: http://elm-chan.org/docs/mmc/mmc_e.html */
 #define SD_CMD0     0       /**< Software reset */
 #define SD_CMD1     1       /**< Initiate initialization process */
@@ -53,11 +60,6 @@
 #define SD_START    0xFE    /**< Start data block */
 #define SD_STOP     0xFD    /**< Stop transmission */
 
-/* Cache modes */
-#define SD_C_EMPTY  0       /**< Cache is empty */
-#define SD_C_READ   1       /**< Cache contains a block cached for reading */
-#define SD_C_WRITE  2       /**< Cache contains a block cached for writing */
-
 #define SD_DEBUG 0
 #if SD_DEBUG
 #define sd_debug(str) kputstr((str))
@@ -89,11 +91,28 @@ ATTR_NOINLINE static void sd_debug_block
 #define sd_debug_block(name, block, size) do { ; } while (0)
 #endif
 
+/* Some functions are implemented in assembly code in "sdasm.S".
+ * Hosted builds for benchmarking set this to 0 to use the C versions. */
+#ifndef SD_ASM
+#define SD_ASM 1
+#endif
+
 /* Amount of time to wait before timing out the SD card detect */
 #define SD_INIT_TIMEOUT (2 * 256) /* 2s in ticks of 1/256'th of a second */
 
+/* Amount of time to sleep between retries while waiting for the SD card
+ * to initialize, so that other processes can run in the meantime */
+#define SD_RETRY_DELAY 2 /* ~8ms in ticks of 1/256'th of a second */
+
+/* Only one process at a time can use the SD card */
+static struct sem sd_bus_lock = SEM_INITIALIZER(sd_bus_lock, 1);
+
 sd_info_t sd_info;
 
+/* Slots for the data and FAT block caches */
+static sd_cache_slot_t sd_data_slots[CONFIG_SD_CACHE_BLOCKS];
+static sd_cache_slot_t sd_fat_slots[CONFIG_SD_FAT_CACHE_BLOCKS];
+
 /**
  * @brief Structure of an SD card command header.
  */
@@ -163,6 +182,42 @@ ATTR_NOINLINE static uint8_t sd_command(const struct sd_card_command *cmd)
     return response;
 }
 
+/**
+ * @brief Stops a multi-block read that is in progress.
+ *
+ * The card will be deselected after the stream is stopped.  Does nothing
+ * if there is no multi-block read in progress.
+ */
+ATTR_NOINLINE static void sd_stream_stop(void)
+{
+    static struct sd_card_command const cmd = {
+        .cmd = SD_CMD12 | 0x40,
+        .arg_bytes = {0, 0, 0, 0},
+        .crc = 0
+    };
+    uint8_t timeout;
+
+    if (!sd_info.stream_block) {
+        return;
+    }
+    sd_info.stream_block = 0;
+
+    /* The card is sending data, so we cannot wait for it to be idle
+     * before sending CMD12.  Send the command immediately and then skip
+     * the stuff byte that precedes the response. */
+    spi_send(&cmd, sizeof(cmd));
+    spi_receive_byte();
+
+    /* Wait for the response byte and then for the card to stop being busy */
+    timeout = 255;
+    while ((spi_receive_byte() & (uint8_t)0x80) != 0 && --timeout != 0)
+        ;
+    timeout = 255;
+    while (spi_receive_byte() != (uint8_t)0xFF && --timeout != 0)
+        ;
+    spi_sdcard_raise_cs();
+}
+
 /**
  * @brief Sends a simple command to the SD card and waits for the
  * response byte.
@@ -206,11 +261,90 @@ ATTR_NOINLINE static uint8_t sd_wait_for_start(void)
     return response;
 }
 
+/**
+ * @brief Discards the contents of all slots in a block cache pool.
+ *
+ * @param[in] cache The cache pool.
+ */
+ATTR_NOINLINE static void sd_cache_invalidate(sd_cache_t *cache)
+{
+    sd_cache_slot_t *slot = cache->slots;
+    uint8_t index;
+    for (index = 0; index < cache->size; ++index, ++slot) {
+        slot->blknum = 0;
+        slot->blknum2 = 0;
+        slot->mode = SD_C_EMPTY;
+    }
+}
+
+/**
+ * @brief Initializes a block cache pool.
+ *
+ * @param[in] cache The cache pool.
+ * @param[in] slots The slots to use for the pool.
+ * @param[in] size The number of slots in the pool.
+ * @param[in] data Points to the data for the slots, or NULL if the
+ * cache blocks could not be allocated.
+ *
+ * @return Pointer to the data for the next pool.
+ */
+static uint8_t *sd_cache_init
+    (sd_cache_t *cache, sd_cache_slot_t *slots, uint8_t size, uint8_t *data)
+{
+    uint8_t index;
+    cache->slots = slots;
+    cache->size = size;
+    cache->hits = 0;
+    cache->misses = 0;
+    for (index = 0; index < size; ++index, ++slots) {
+        slots->age = index;
+        slots->data = data;
+        if (data)
+            data += SD_BLKSIZE;
+    }
+    sd_cache_invalidate(cache);
+    return data;
+}
+
 void sd_init(void)
 {
+    uint8_t *data;
+
     spi_init();
     sd_info.detect = 0;
     sd_info.sdhc = 0;
+    sd_info.stream_block = 0;
+
+    /* Allocate the cache blocks out of user space RAM to avoid using
+     * up the more precious kernel RAM.  If the allocation fails, then
+     * the data pointers will be NULL and SD card detection will fail. */
+    data = kmalloc_user_alloc
+        ((CONFIG_SD_CACHE_BLOCKS + CONFIG_SD_FAT_CACHE_BLOCKS) * SD_BLKSIZE);
+    data = sd_cache_init
+        (&(sd_info.cache), sd_data_slots, CONFIG_SD_CACHE_BLOCKS, data);
+    sd_cache_init
+        (&(sd_info.fat_cache), sd_fat_slots, CONFIG_SD_FAT_CACHE_BLOCKS, data);
+}
+
+int sd_lock(void)
+{
+    return sem_wait(&sd_bus_lock);
+}
+
+void sd_unlock(void)
+{
+    sem_signal(&sd_bus_lock);
+}
+
+/**
+ * @brief Sleeps between retries while waiting for the SD card to
+ * initialize, with the card deselected.
+ */
+static void sd_retry_sleep(void)
+{
+    spi_sdcard_raise_cs();
+    timer_sleep(SD_RETRY_DELAY, NULL);
+    spi_sdcard_lower_cs();
 }
 
 ATTR_NOINLINE uint8_t sd_detect(void)
@@ -221,9 +355,13 @@ ATTR_NOINLINE uint8_t sd_detect(void)
     };
     struct sd_card_command cmd;
     unsigned short timeout_base;
+    uint8_t *block;
     uint8_t status;
     uint8_t version;
 
+    /* Cannot detect the card while a multi-block read is in progress */
+    sd_stream_stop();
+
     /* Have we detected the SD card previously? */
     if (sd_info.detect) {
         /*
@@ -237,7 +375,7 @@ ATTR_NOINLINE uint8_t sd_detect(void)
         spi_sdcard_lower_cs();
         status = sd_simple_command(&cmd, SD_CMD10 + 0x40);
         if (status == SD_R1_READY) {
-            if (sd_wait_for_start()) {
+            if (sd_wait_for_start() == SD_START) {
                 /* Receive the 16 bytes of the CID and two checksum bytes.
                  * We don't care what the CID value is, so throw it away. */
                 spi_blank(18);
@@ -256,6 +394,15 @@ ATTR_NOINLINE uint8_t sd_detect(void)
     sd_info.part_offset = 0;
     sd_info.part_size = 0;
 
+    /* Anything that was cached belongs to the previous card.  Use the
+     * first cache slot as a scratch buffer while detecting the card. */
+    sd_cache_invalidate(&(sd_info.cache));
+    sd_cache_invalidate(&(sd_info.fat_cache));
+    block = sd_data_slots[0].data;
+    if (!block) {
+        goto fail;
+    }
+
     /* Wake up the SD card */
     sd_debug("\nSD wakeup\n");
     sd_wakeup();
@@ -278,6 +425,7 @@ ATTR_NOINLINE uint8_t sd_detect(void)
         if ((sys_clock() - timeout_base) >= SD_INIT_TIMEOUT) {
             goto fail;
         }
+        sd_retry_sleep();
     }
     version = 1;
 
@@ -312,6 +460,7 @@ ATTR_NOINLINE uint8_t sd_detect(void)
         if ((sys_clock() - timeout_base) >= SD_INIT_TIMEOUT) {
             goto fail;
         }
+        sd_retry_sleep();
     }
 
     /* Send CMD58 to check for SDHC support (version 2 cards only) */
@@ -332,42 +481,42 @@ ATTR_NOINLINE uint8_t sd_detect(void)
     if (sd_simple_command(&cmd, SD_CMD9 + 0x40) != SD_R1_READY) {
         goto fail;
     }
-    if (!sd_wait_for_start()) {
+    if (sd_wait_for_start() != SD_START) {
         goto fail;
     }
-    spi_receive(sd_info.block, 18);
-    sd_debug_block("CSD", sd_info.block, 16);
+    spi_receive(block, 18);
+    sd_debug_block("CSD", block, 16);
 
-#if 1
+#if SD_ASM
     /* Use an assembly replacement for the size code because we
      * can do the shifts more efficiently in assembly code. */
-    extern uint32_t sd_get_size(void);
-    sd_info.part_size = sd_get_size();
+    extern uint32_t sd_get_size(uint8_t *csd);
+    sd_info.part_size = sd_get_size(block);
     if (!sd_info.part_size) {
         goto fail;
     }
 #else
     /* Get the number of blocks on the SD card from the CSD */
-    status = sd_info.block[0] & 0xC0;
+    status = block[0] & 0xC0;
     if (status == 0x00) {
         /* Version 1 CSD: (C_SIZE + 1) << (C_SIZE_MULT + READ_BL_LEN - 7) */
-        uint8_t read_bl_len = sd_info.block[5] & (uint8_t)0x0F;
+        uint8_t read_bl_len = block[5] & (uint8_t)0x0F;
         uint8_t c_size_mult =
-            (sd_info.block[9] & (uint8_t)0x03) << 1;
-        if (sd_info.block[10] & (uint8_t)0x80)
+            (block[9] & (uint8_t)0x03) << 1;
+        if (block[10] & (uint8_t)0x80)
             ++c_size_mult;
         sd_info.part_size =
-            (((uint32_t)(sd_info.block[6] & (uint8_t)0x03)) << 10) |
-            (((uint32_t)(sd_info.block[7])) << 2) |
-             ((uint32_t)(sd_info.block[8] >> 6));
+            (((uint32_t)(block[6] & (uint8_t)0x03)) << 10) |
+            (((uint32_t)(block[7])) << 2) |
+             ((uint32_t)(block[8] >> 6));
         sd_info.part_size =
             (sd_info.part_size + 1) << (c_size_mult + read_bl_len - (uint8_t)7);
     } else if (status == 0x40) {
         /* Version 2 CSD: (C_SIZE + 1) << 10 */
         sd_info.part_size =
-            (((uint32_t)(sd_info.block[9])) << 8) |
-            (((uint32_t)(sd_info.block[8])) << 16) |
-            (((uint32_t)(sd_info.block[7])) << 24);
+            (((uint32_t)(block[9])) << 8) |
+            (((uint32_t)(block[8])) << 16) |
+            (((uint32_t)(block[7])) << 24);
         sd_info.part_size = (sd_info.part_size + 0x100) << 2;
     } else {
         goto fail;
@@ -376,32 +525,32 @@ ATTR_NOINLINE uint8_t sd_detect(void)
 
     /* See if we have a partition table in block 0 */
     sd_debug("MBR\n");
-    if (sd_read(0) != SD_R1_READY) {
+    if (sd_read(0, block) != SD_R1_READY) {
         goto fail;
     }
-    if (sd_info.block[510] != (uint8_t)0x55) {
+    if (block[510] != (uint8_t)0x55) {
         /* Last two bytes should be 0x55, 0xAA */
         goto fail;
     }
-    if (sd_info.block[511] != (uint8_t)0xAA) {
+    if (block[511] != (uint8_t)0xAA) {
         goto fail;
     }
-    status = sd_info.block[450];
+    status = block[450];
     if (status == 0x0C) {
         /* First partition is in FAT32 format - find its extents */
-        sd_info.part_offset = *((uint32_t *)(sd_info.block + 454));
-        sd_info.part_size   = *((uint32_t *)(sd_info.block + 458));
+        sd_info.part_offset = *((uint32_t *)(block + 454));
+        sd_info.part_size   = *((uint32_t *)(block + 458));
 
         /* Read block 0 of the partition */
         sd_debug("PBR\n");
-        if (sd_read(sd_info.part_offset) != SD_R1_READY) {
+        if (sd_read(sd_info.part_offset, block) != SD_R1_READY) {
             goto fail;
         }
-        if (sd_info.block[510] != (uint8_t)0x55) {
+        if (block[510] != (uint8_t)0x55) {
             /* Last two bytes should be 0x55, 0xAA */
             goto fail;
         }
-        if (sd_info.block[511] != (uint8_t)0xAA) {
+        if (block[511] != (uint8_t)0xAA) {
             goto fail;
         }
     } else if (status == 0x0E) {
@@ -414,28 +563,28 @@ ATTR_NOINLINE uint8_t sd_detect(void)
 
     /* Does block 0 look like the header for a FAT32 partition? */
     sd_debug("FAT32 Check\n");
-    if (sd_info.block[11] != 0 || sd_info.block[12] != 2) {
+    if (block[11] != 0 || block[12] != 2) {
         /* Sector size is not 512 */
         goto fail;
     }
-    sd_info.cluster_size = sd_info.block[13];
+    sd_info.cluster_size = block[13];
     if (!memchr(cluster_sizes, sd_info.cluster_size, sizeof(cluster_sizes))) {
         /* Invalid cluster size */
         goto fail;
     }
-    if (sd_info.block[16] != 2) {
+    if (block[16] != 2) {
         /* FAT32 partitions must have two FAT's */
         goto fail;
     }
-    if (sd_info.block[17] != 0 || sd_info.block[18] != 0) {
+    if (block[17] != 0 || block[18] != 0) {
         /* Root directory entry count must be zero for FAT32 */
         goto fail;
     }
-    if (sd_info.block[19] != 0 || sd_info.block[20] != 0) {
+    if (block[19] != 0 || block[20] != 0) {
         /* Total sector count must be zero for FAT32 */
         goto fail;
     }
-    status = sd_info.block[21];
+    status = block[21];
     if (status != (uint8_t)0xF0 && status < (uint8_t)0xF8) {
         /* Media type must be 0xF0 or 0xF8..0xFF for FAT */
         goto fail;
@@ -450,12 +599,12 @@ ATTR_NOINLINE uint8_t sd_detect(void)
     }
 
     /* Find the size and position of the two FAT's */
-    sd_info.fat_size = *((const uint32_t *)(sd_info.block + 36));
-    sd_info.fat1 = *((const uint16_t *)(sd_info.block + 14));
+    sd_info.fat_size = *((const uint32_t *)(block + 36));
+    sd_info.fat1 = *((const uint16_t *)(block + 14));
     sd_info.fat2 = sd_info.fat1 + sd_info.fat_size;
 
     /* Find the root directory cluster number */
-    sd_info.root = *((const uint32_t *)(sd_info.block + 44));
+    sd_info.root = *((const uint32_t *)(block + 44));
 
     /* Find the data section of the partition where the clusters reside */
     sd_info.cluster_offset = sd_info.fat2 + sd_info.fat_size;
@@ -468,11 +617,6 @@ ATTR_NOINLINE uint8_t sd_detect(void)
     sd_info.fat2 += sd_info.part_offset;
     sd_info.cluster_offset += sd_info.part_offset;
 
-    /* Nothing is cached yet */
-    sd_info.cache_block = 0;
-    sd_info.cache_block2 = 0;
-    sd_info.cache_mode = SD_C_EMPTY;
-
     /* Dump the information about the SD card */
     sd_debug_value("version", version);
     sd_debug_value("sdhc", sd_info.sdhc);
@@ -506,7 +650,7 @@ uint8_t sd_redetect(void)
     return sd_detect();
 }
 
-#if 0 /* Implemented in assembly code */
+#if !SD_ASM /* Implemented in assembly code */
 
 ATTR_NOINLINE uint32_t sd_cluster_to_block(uint32_t cluster)
 {
@@ -543,14 +687,24 @@ static uint32_t sd_adjust_block_number(uint32_t blknum)
     return blknum;
 }
 
-ATTR_NOINLINE uint8_t sd_read(uint32_t blknum)
+/**
+ * @brief Sends a read command for a block to the SD card.
+ *
+ * @param[in] command The read command; SD_CMD17 or SD_CMD18.
+ * @param[in] blknum Block number to start reading from.
+ *
+ * @return The response byte for the command.
+ *
+ * The card is left selected if the command succeeds.
+ */
+ATTR_NOINLINE static uint8_t sd_start_read(uint8_t command, uint32_t blknum)
 {
     /* Adjust the block number for the partition offset and SD card type */
     blknum = sd_adjust_block_number(blknum);
 
-    /* Send the read command to the SD card and wait for it to start */
+    /* Send the read command to the SD card */
     struct sd_card_command cmd = {
-        .cmd = SD_CMD17 | 0x40,
+        .cmd = command | 0x40,
         .arg_bytes[0] = (uint8_t)(blknum >> 24),
         .arg_bytes[1] = (uint8_t)(blknum >> 16),
         .arg_bytes[2] = (uint8_t)(blknum >> 8),
@@ -561,90 +715,371 @@ ATTR_NOINLINE uint8_t sd_read(uint32_t blknum)
     uint8_t response = sd_command(&cmd);
     if (response != SD_R1_READY) {
         spi_sdcard_raise_cs();
-        return response;
     }
-    if (!sd_wait_for_start()) {
-        spi_sdcard_raise_cs();
+    return response;
+}
+
+/**
+ * @brief Receives the next data block from the SD card.
+ *
+ * @param[out] data Buffer of SD_BLKSIZE bytes to receive the data.
+ *
+ * @return SD_R1_READY if the block was received, or 0xFF on error.
+ */
+ATTR_NOINLINE static uint8_t sd_receive_block(void *data)
+{
+    /* Wait for the data to start */
+    if (sd_wait_for_start() != SD_START) {
         return 0xFF;
     }
 
     /* Receive the data */
-    spi_receive(sd_info.block, SD_BLKSIZE);
+    spi_receive(data, SD_BLKSIZE);
 
     /* Read the two CRC bytes and discard them */
     spi_receive_byte();
     spi_receive_byte();
+    return SD_R1_READY;
+}
 
-    /* Lower the chip select and return */
-    spi_sdcard_raise_cs();
+ATTR_NOINLINE uint8_t sd_read(uint32_t blknum, void *data)
+{
+    uint8_t response;
+    sd_stream_stop();
+    response = sd_start_read(SD_CMD17, blknum);
+    if (response == SD_R1_READY) {
+        response = sd_receive_block(data);
+        spi_sdcard_raise_cs();
+    }
+    return response;
+}
+
+ATTR_NOINLINE uint8_t sd_read_stream(uint32_t blknum, void *data)
+{
+    uint8_t response;
+
+    /* Start a new multi-block read if we aren't already streaming
+     * from the requested block.  Block 0 is never streamed because
+     * "stream_block" uses it to indicate that there is no stream. */
+    if (sd_info.stream_block != blknum || !blknum) {
+        sd_stream_stop();
+        if (!blknum) {
+            return sd_read(blknum, data);
+        }
+        response = sd_start_read(SD_CMD18, blknum);
+        if (response != SD_R1_READY) {
+            return response;
+        }
+        sd_info.stream_block = blknum;
+    }
+
+    /* Receive the next block in the stream, leaving the card selected */
+    response = sd_receive_block(data);
+    if (response != SD_R1_READY) {
+        sd_stream_stop();
+        return response;
+    }
+    ++(sd_info.stream_block);
     return SD_R1_READY;
 }
 
-ATTR_NOINLINE uint8_t sd_write(uint32_t blknum)
+ATTR_NOINLINE uint8_t sd_write(uint32_t blknum, const void *data)
 {
+    sd_stream_stop();
     /* TODO */
     (void)blknum;
+    (void)data;
     return 0xFF;
 }
 
-ATTR_NOINLINE uint8_t sd_cache_read(uint32_t blknum)
+/**
+ * @brief Marks a cache slot as the most recently used.
+ *
+ * @param[in] cache The cache pool that contains the slot.
+ * @param[in] slot The cache slot.
+ */
+static void sd_cache_touch(sd_cache_t *cache, sd_cache_slot_t *slot)
+{
+    sd_cache_slot_t *current = cache->slots;
+    uint8_t age = slot->age;
+    uint8_t index;
+    for (index = 0; index < cache->size; ++index, ++current) {
+        if (current->age < age)
+            ++(current->age);
+    }
+    slot->age = 0;
+}
+
+/**
+ * @brief Flushes a cache slot back to the SD card if it has been modified.
+ *
+ * @param[in] slot The cache slot.
+ *
+ * @return The response byte for the command.
+ */
+static uint8_t sd_cache_flush_slot(sd_cache_slot_t *slot)
 {
     uint8_t status;
+    if (slot->mode == SD_C_WRITE) {
+        status = sd_write(slot->blknum, slot->data);
+        if (status != SD_R1_READY)
+            return status;
+        if (slot->blknum2) {
+            status = sd_write(slot->blknum2, slot->data);
+            if (status != SD_R1_READY)
+                return status;
+        }
+        slot->blknum2 = 0;
+        slot->mode = SD_C_READ;
+    }
+    return SD_R1_READY;
+}
 
-    /* Do we already have this block in the cache? */
-    if (blknum == sd_info.cache_block) {
-        if (sd_info.cache_mode != SD_C_EMPTY) {
-            return SD_R1_READY;
+/**
+ * @brief Looks up a block in a cache pool.
+ *
+ * @param[in] cache The cache pool to look in.
+ * @param[in] blknum The block number to look for.
+ *
+ * @return The slot containing the block, or NULL if it is not cached.
+ *
+ * This does not affect the LRU order of the slots in the pool.
+ */
+ATTR_NOINLINE static sd_cache_slot_t *sd_cache_lookup
+    (sd_cache_t *cache, uint32_t blknum)
+{
+    sd_cache_slot_t *slot = cache->slots;
+    uint8_t index;
+    for (index = 0; index < cache->size; ++index, ++slot) {
+        if (slot->mode != SD_C_EMPTY && slot->blknum == blknum)
+            return slot;
+    }
+    return 0;
+}
+
+/**
+ * @brief Evicts the contents of a slot in a cache pool to make room
+ * for a new block.
+ *
+ * @param[in] cache The cache pool.
+ * @param[out] slot Returns the slot, which is marked as the most
+ * recently used.
+ *
+ * @return SD_R1_IDLE if the returned slot is empty and ready for the
+ * block to be loaded into it, or an error response if the previous
+ * contents of the slot could not be flushed.
+ *
+ * An empty slot is used if there is one, or the least recently used
+ * slot otherwise.
+ */
+ATTR_NOINLINE static uint8_t sd_cache_evict
+    (sd_cache_t *cache, sd_cache_slot_t **slot)
+{
+    sd_cache_slot_t *victim = 0;
+    sd_cache_slot_t *current = cache->slots;
+    uint8_t oldest = cache->size - 1;
+    uint8_t index;
+    uint8_t status;
+
+    /* Look for an empty slot or the least recently used slot */
+    for (index = 0; index < cache->size; ++index, ++current) {
+        if (current->mode == SD_C_EMPTY) {
+            victim = current;
+            break;
+        } else if (current->age == oldest) {
+            victim = current;
         }
     }
 
-    /* Flush the currently cached block out */
-    if (sd_info.cache_mode != SD_C_EMPTY) {
-        status = sd_cache_flush();
+    /* Flush the block that is being replaced out */
+    status = sd_cache_flush_slot(victim);
+    if (status != SD_R1_READY)
+        return status;
+    victim->blknum = 0;
+    victim->mode = SD_C_EMPTY;
+    sd_cache_touch(cache, victim);
+    *slot = victim;
+    return SD_R1_IDLE;
+}
+
+/**
+ * @brief Finds a slot in a cache pool for a block.
+ *
+ * @param[in] cache The cache pool to look in.
+ * @param[in] blknum The block number to look for.
+ * @param[out] slot Returns the slot for the block.
+ *
+ * @return SD_R1_READY if the block is already in the returned slot,
+ * SD_R1_IDLE if the returned slot is empty and ready for the block to be
+ * loaded into it, or an error response if the previous contents of the
+ * least recently used slot could not be flushed.
+ */
+ATTR_NOINLINE static uint8_t sd_cache_find
+    (sd_cache_t *cache, uint32_t blknum, sd_cache_slot_t **slot)
+{
+    /* Do we already have this block in the cache? */
+    sd_cache_slot_t *current = sd_cache_lookup(cache, blknum);
+    if (current) {
+        ++(cache->hits);
+        sd_cache_touch(cache, current);
+        *slot = current;
+        return SD_R1_READY;
+    }
+
+    /* Evict the least recently used block to make room */
+    ++(cache->misses);
+    return sd_cache_evict(cache, slot);
+}
+
+/**
+ * @brief Reads a block from a cache pool, or the physical SD media.
+ *
+ * @param[in] cache The cache pool to use.
+ * @param[in] blknum Block number to read from.
+ * @param[out] data Returns a pointer to the cached data for the block.
+ *
+ * @return The response byte for the command.
+ */
+ATTR_NOINLINE static uint8_t sd_cache_read_pool
+    (sd_cache_t *cache, uint32_t blknum, uint8_t **data)
+{
+    sd_cache_slot_t *slot;
+    uint8_t status;
+
+    /* Find the slot to use */
+    status = sd_cache_find(cache, blknum, &slot);
+    if (status == SD_R1_IDLE) {
+        /* Read the new block in */
+        status = sd_read(blknum, slot->data);
         if (status != SD_R1_READY)
             return status;
-        sd_info.cache_block = 0;
-        sd_info.cache_block2 = 0;
-        sd_info.cache_mode = SD_C_EMPTY;
-    }
 
-    /* Read the new block in */
-    status = sd_read(blknum);
-    if (status != SD_R1_READY)
+        /* Record that the block is now cached */
+        slot->blknum = blknum;
+        slot->mode = SD_C_READ;
+    } else if (status != SD_R1_READY) {
         return status;
+    }
+    *data = slot->data;
+    return SD_R1_READY;
+}
+
+uint8_t sd_cache_read(uint32_t blknum, uint8_t **data)
+{
+    return sd_cache_read_pool(&(sd_info.cache), blknum, data);
+}
+
+ATTR_NOINLINE uint8_t sd_cache_read_sequential
+    (uint32_t blknum, uint8_t read_ahead, uint8_t **data)
+{
+    sd_cache_t *cache = &(sd_info.cache);
+    sd_cache_slot_t *slot;
+    uint8_t status;
 
-    /* Record that the block is now cached */
-    sd_info.cache_block = blknum;
-    sd_info.cache_block2 = 0;
-    sd_info.cache_mode = SD_C_READ;
+    /* Find the slot to use and read the block using a multi-block read */
+    status = sd_cache_find(cache, blknum, &slot);
+    if (status == SD_R1_IDLE) {
+        status = sd_read_stream(blknum, slot->data);
+        if (status != SD_R1_READY)
+            return status;
+        slot->blknum = blknum;
+        slot->mode = SD_C_READ;
+    } else if (status != SD_R1_READY) {
+        return status;
+    }
+    *data = slot->data;
+
+    /* While the stream is positioned on the next block, read it ahead
+     * into the least recently used slot.  The depth is less than the
+     * size of the cache, so the block we just read is never evicted. */
+    if (read_ahead > CONFIG_SD_READ_AHEAD)
+        read_ahead = CONFIG_SD_READ_AHEAD;
+    while (read_ahead > 0) {
+        ++blknum;
+        if (sd_info.stream_block != blknum || sd_cache_lookup(cache, blknum))
+            break;
+        if (sd_cache_evict(cache, &slot) != SD_R1_IDLE)
+            break;
+        if (sd_read_stream(blknum, slot->data) != SD_R1_READY)
+            break;
+        slot->blknum = blknum;
+        slot->mode = SD_C_READ;
+        --read_ahead;
+    }
     return SD_R1_READY;
 }
 
-ATTR_NOINLINE uint8_t sd_cache_write_prepare(uint32_t blknum)
+ATTR_NOINLINE uint8_t sd_cache_read_direct(uint32_t blknum, void *data)
+{
+    sd_cache_t *cache = &(sd_info.cache);
+    sd_cache_slot_t *slot = sd_cache_lookup(cache, blknum);
+    if (slot) {
+        /* The cached copy may be newer than the copy on the card */
+        ++(cache->hits);
+        memcpy(data, slot->data, SD_BLKSIZE);
+        return SD_R1_READY;
+    }
+    ++(cache->misses);
+    return sd_read_stream(blknum, data);
+}
+
+uint8_t sd_cache_read_fat(uint32_t blknum, uint8_t **data)
+{
+    return sd_cache_read_pool(&(sd_info.fat_cache), blknum, data);
+}
+
+ATTR_NOINLINE uint8_t sd_cache_write_prepare(uint32_t blknum, uint8_t **data)
 {
     // TODO
     (void)blknum;
+    (void)data;
     return 0xFF;
 }
 
-ATTR_NOINLINE uint8_t sd_cache_write_prepare_fat(uint32_t blknum)
+ATTR_NOINLINE uint8_t sd_cache_write_prepare_fat
+    (uint32_t blknum, uint8_t **data)
 {
     // TODO
     (void)blknum;
+    (void)data;
     return 0xFF;
 }
 
-ATTR_NOINLINE uint8_t sd_cache_write_prepare_zero(uint32_t blknum)
+ATTR_NOINLINE uint8_t sd_cache_write_prepare_zero
+    (uint32_t blknum, uint8_t **data)
 {
     // TODO
     (void)blknum;
+    (void)data;
     return 0xFF;
 }
 
-ATTR_NOINLINE uint8_t sd_cache_flush(void)
+/**
+ * @brief Flushes pending writes in a cache pool to the SD card.
+ *
+ * @param[in] cache The cache pool.
+ *
+ * @return The response byte for the command.
+ */
+ATTR_NOINLINE static uint8_t sd_cache_flush_pool(sd_cache_t *cache)
 {
-    // TODO
+    sd_cache_slot_t *slot = cache->slots;
+    uint8_t index;
+    uint8_t status;
+    for (index = 0; index < cache->size; ++index, ++slot) {
+        status = sd_cache_flush_slot(slot);
+        if (status != SD_R1_READY)
+            return status;
+    }
     return SD_R1_READY;
 }
 
+ATTR_NOINLINE uint8_t sd_cache_flush(void)
+{
+    uint8_t status = sd_cache_flush_pool(&(sd_info.fat_cache));
+    if (status != SD_R1_READY)
+        return status;
+    return sd_cache_flush_pool(&(sd_info.cache));
+}
+
 #endif /* CONFIG_SD && CONFIG_SPI */
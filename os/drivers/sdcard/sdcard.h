@@ -10,6 +10,7 @@
 #define MOSNIX_DRIVERS_SDCARD_H
 
 #include "drivers/spi/spi.h"
+#include <mosnix/config.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -37,6 +38,52 @@ extern "C" {
  */
 #define SD_BLKSIZE  512
 
+/* Cache modes */
+#define SD_C_EMPTY  0       /**< Cache slot is empty */
+#define SD_C_READ   1       /**< Cache slot contains a block cached for reading */
+#define SD_C_WRITE  2       /**< Cache slot contains a block cached for writing */
+
+/**
+ * @brief Information about a slot in the SD card's block cache.
+ */
+typedef struct
+{
+    /** Sector number of the cached block */
+    uint32_t blknum;
+
+    /** Sector number of the second copy for FAT write operations */
+    uint32_t blknum2;
+
+    /** Mode for the cached block (SD_C_EMPTY if nothing cached) */
+    uint8_t mode;
+
+    /** Age of the slot for LRU replacement; 0 is the most recently used */
+    uint8_t age;
+
+    /** Points to the SD_BLKSIZE bytes of data for the cached block */
+    uint8_t *data;
+
+} sd_cache_slot_t;
+
+/**
+ * @brief Information about a pool of slots in the SD card's block cache.
+ */
+typedef struct
+{
+    /** Points to the slots in the pool */
+    sd_cache_slot_t *slots;
+
+    /** Number of slots in the pool */
+    uint8_t size;
+
+    /** Number of requests that were satisfied from the pool */
+    uint32_t hits;
+
+    /** Number of requests that had to read the block from the SD card */
+    uint32_t misses;
+
+} sd_cache_t;
+
 /**
  * @brief Information about the inserted SD card and FAT32 volume.
  *
@@ -83,17 +130,15 @@ typedef struct
     /** Number of clusters in the partition */
     uint32_t cluster_count;     /* 0x20 */
 
-    /** Sector number of the cached block */
-    uint32_t cache_block;       /* 0x24 */
+    /** Block cache for file and directory data */
+    sd_cache_t cache;           /* 0x24 */
 
-    /** Sector number of the second copy for FAT write operations */
-    uint32_t cache_block2;      /* 0x28 */
-
-    /** Mode for the cached block (0 if nothing cached) */
-    uint8_t cache_mode;         /* 0x2C */
+    /** Block cache for sectors in the FAT */
+    sd_cache_t fat_cache;
 
-    /** Cached block */
-    uint8_t block[SD_BLKSIZE];  /* 0x2D */
+    /** Next block number in the multi-block read that is in progress,
+     *  or zero if there is no multi-block read in progress */
+    uint32_t stream_block;
 
 } sd_info_t;
 
@@ -108,10 +153,31 @@ extern sd_info_t sd_info;
  */
 void sd_init(void);
 
+/**
+ * @brief Acquires exclusive use of the SD card and its SPI bus.
+ *
+ * @return 0 if the SD card was acquired, or -EINTR if the wait for
+ * another process to release it was interrupted.
+ *
+ * The lock must be held across a whole sequence of SD card operations,
+ * including any use of the cached data that they return.  Card detection
+ * sleeps while waiting for the card to initialize, and another process
+ * must not issue commands on the bus or replace cached blocks meanwhile.
+ */
+int sd_lock(void);
+
+/**
+ * @brief Releases the SD card and its SPI bus.
+ */
+void sd_unlock(void);
+
 /**
  * @brief Detects the presence of an SD card in the slot.
  *
  * @return SD_DETECT_NONE, SD_DETECT_NEW, or SD_DETECT_EXISTING.
+ *
+ * The caller must hold the SD card lock.  This may sleep while
+ * waiting for the card to initialize.
  */
 uint8_t sd_detect(void);
 
@@ -120,6 +186,8 @@ uint8_t sd_detect(void);
  * the detection from scratch.
  *
  * @return SD_DETECT_NONE, SD_DETECT_NEW, or SD_DETECT_EXISTING.
+ *
+ * The caller must hold the SD card lock.
  */
 uint8_t sd_redetect(void);
 
@@ -136,62 +204,143 @@ uint32_t sd_cluster_to_block(uint32_t cluster);
  * @brief Reads a block of data from the SD card.
  *
  * @param[in] blknum Block number to read from.
+ * @param[out] data Buffer of SD_BLKSIZE bytes to receive the data.
  *
  * @return The response byte for the command, which will be SD_R1_READY if
  * the block was read successfully.
  */
-uint8_t sd_read(uint32_t blknum);
+uint8_t sd_read(uint32_t blknum, void *data);
+
+/**
+ * @brief Reads a block of data from the SD card as part of a sequential
+ * multi-block read.
+ *
+ * @param[in] blknum Block number to read from.
+ * @param[out] data Buffer of SD_BLKSIZE bytes to receive the data.
+ *
+ * @return The response byte for the command, which will be SD_R1_READY if
+ * the block was read successfully.
+ *
+ * If a multi-block read is already positioned at @a blknum, then the block
+ * is received without sending a new command to the card.  Otherwise the
+ * current multi-block read is stopped and a new one is started.
+ * The multi-block read is left open for the next call, and will be
+ * stopped by any other operation on the SD card.
+ */
+uint8_t sd_read_stream(uint32_t blknum, void *data);
 
 /**
  * @brief Writes a block of data to the SD card.
  *
  * @param[in] blknum Block number to write to.
+ * @param[in] data Buffer of SD_BLKSIZE bytes containing the data to write.
  *
  * @return The response byte for the command.
  */
-uint8_t sd_write(uint32_t blknum);
+uint8_t sd_write(uint32_t blknum, const void *data);
 
 /**
  * @brief Reads a block from the cache, or the physical SD media.
  *
  * @param[in] blknum Block number to read from.
+ * @param[out] data Returns a pointer to the cached data for the block.
  *
  * @return The response byte for the command, which will be SD_R1_READY if
  * the block was read successfully.
  *
  * If the block is already in the cache, then this will return immediately
- * without reading it again.
+ * without reading it again.  Otherwise the least recently used slot in
+ * the cache is replaced with the new block.
+ *
+ * The pointer that is returned in @a data is valid until the next call
+ * that may replace a block in the cache.
+ */
+uint8_t sd_cache_read(uint32_t blknum, uint8_t **data);
+
+/**
+ * @brief Reads a block from the cache, or the physical SD media,
+ * when reading sequentially through a file or directory.
+ *
+ * @param[in] blknum Block number to read from.
+ * @param[in] read_ahead Number of blocks immediately after @a blknum
+ * that are also part of the same file or directory, or 255 if there are
+ * at least that many.
+ * @param[out] data Returns a pointer to the cached data for the block.
+ *
+ * @return The response byte for the command, which will be SD_R1_READY if
+ * the block was read successfully.
+ *
+ * This is the same as sd_cache_read() except that blocks that are not in
+ * the cache are read with sd_read_stream().  Up to CONFIG_SD_READ_AHEAD of
+ * the following blocks are also read into the cache while the multi-block
+ * read is in progress, replacing the least recently used blocks.
+ */
+uint8_t sd_cache_read_sequential
+    (uint32_t blknum, uint8_t read_ahead, uint8_t **data);
+
+/**
+ * @brief Reads a whole block into a caller-supplied buffer, bypassing
+ * the cache if the block is not already cached.
+ *
+ * @param[in] blknum Block number to read from.
+ * @param[out] data Buffer of SD_BLKSIZE bytes to receive the data.
+ *
+ * @return The response byte for the command, which will be SD_R1_READY if
+ * the block was read successfully.
+ *
+ * If the block is in the cache, then it is copied from there.  Otherwise it
+ * is read directly from the SD card into @a data with sd_read_stream(),
+ * which avoids copying the data a second time.  The block is not added
+ * to the cache.
+ */
+uint8_t sd_cache_read_direct(uint32_t blknum, void *data);
+
+/**
+ * @brief Reads a FAT block from the cache, or the physical SD media.
+ *
+ * @param[in] blknum FAT block number to read from.
+ * @param[out] data Returns a pointer to the cached data for the block.
+ *
+ * @return The response byte for the command, which will be SD_R1_READY if
+ * the block was read successfully.
+ *
+ * This is the same as sd_cache_read() except that FAT blocks are cached
+ * separately to file and directory data.  Following a cluster chain
+ * will not evict the data that is being read from the clusters.
  */
-uint8_t sd_cache_read(uint32_t blknum);
+uint8_t sd_cache_read_fat(uint32_t blknum, uint8_t **data);
 
 /**
  * @brief Prepares to write a block to SD media.
  *
  * @param[in] blknum Block number to write to.
+ * @param[out] data Returns a pointer to the cached data for the block.
  *
  * @return The response byte for the command.
  *
  * This function will read the current contents of the block into the cache
  * and prepare it for writing.
  */
-uint8_t sd_cache_write_prepare(uint32_t blknum);
+uint8_t sd_cache_write_prepare(uint32_t blknum, uint8_t **data);
 
 /**
  * @brief Prepares to write a FAT block to SD media.
  *
  * @param[in] blknum FAT block number to write to.
+ * @param[out] data Returns a pointer to the cached data for the block.
  *
  * @return The response byte for the command.
  *
  * This block number is assumed to be within FAT1.  This function will also
  * prepare to write a copy of the data to FAT2 when the next flush happens.
  */
-uint8_t sd_cache_write_prepare_fat(uint32_t blknum);
+uint8_t sd_cache_write_prepare_fat(uint32_t blknum, uint8_t **data);
 
 /**
  * @brief Prepares to write a block to SD media that is initially zero.
  *
  * @param[in] blknum Block number to write to.
+ * @param[out] data Returns a pointer to the cached data for the block.
  *
  * @return The response byte for the command.
  *
@@ -199,7 +348,7 @@ uint8_t sd_cache_write_prepare_fat(uint32_t blknum);
  * prepare it for writing.  This is faster than sd_cache_write_prepare()
  * when a new block is being written to a file.
  */
-uint8_t sd_cache_write_prepare_zero(uint32_t blknum);
+uint8_t sd_cache_write_prepare_zero(uint32_t blknum, uint8_t **data);
 
 /**
  * @brief Flushes pending writes to the SD card.
@@ -8,70 +8,303 @@
 
 #include <mosnix/file.h>
 #include <mosnix/target.h>
+#include "drivers/tty/ttyring.h"
 #include <bits/fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
 #include <errno.h>
+#include <string.h>
 
-/* Basic TTY that wraps the target's __chrin() and __chrout() functions */
+/* Basic TTY that wraps the target's __chrin() function for input and
+ * the console transmit ring for output */
 
 #if defined(CONFIG_CONSOLE_BASIC_TTY)
 
-static ssize_t basic_tty_read(struct file *file, void *data, size_t size)
+#if CONFIG_TTY_LINE_MAX < 2 || CONFIG_TTY_LINE_MAX > 255
+#error "CONFIG_TTY_LINE_MAX must be between 2 and 255"
+#endif
+
+/** Terminal settings for the console, which start in canonical mode */
+static struct termios basic_tty_termios = {
+    .c_iflag = ICRNL,
+    .c_oflag = OPOST | ONLCR,
+    .c_cflag = 0,
+    .c_lflag = ICANON | ECHO | ECHOE | ECHOK,
+    .c_cc = {0x03, 0x04, 0x7F, 0x15, 1, 0}
+};
+
+/** Line of input that is being edited in canonical mode */
+static char basic_tty_line[CONFIG_TTY_LINE_MAX];
+
+/** Number of bytes in "basic_tty_line" */
+static uint8_t basic_tty_line_len;
+
+/** Position in "basic_tty_line" to read from next */
+static uint8_t basic_tty_line_posn;
+
+/** Non-zero if the line in "basic_tty_line" is complete */
+static uint8_t basic_tty_line_done;
+
+/**
+ * @brief Waits for a character from the console.
+ *
+ * @return The character, or -EINTR if the wait was interrupted.
+ *
+ * If the target can poll for input, then the process sleeps until the
+ * target's receive interrupt signals "tty_rx_sem".  The process is
+ * boosted when it wakes up so that it can respond to the input quickly.
+ */
+static int basic_tty_getc(void)
 {
-    char *d = (char *)data;
-    int result = 0;
-    (void)file;
-    while (size > 0) {
-        int c = __chrin();
+#if CONFIG_CHROUT_NO_WAIT
+    int c;
+    while ((c = __chrin_no_wait()) < 0) {
+        c = sem_wait_interactive(&tty_rx_sem);
         if (c < 0)
             break;
-        if (c == '\r' || c == '\n') {
-            d[result++] = '\n';
-#if !CONFIG_CHRIN_ECHO
+    }
+    return c;
+#else
+    return __chrin();
+#endif
+}
+
+/**
+ * @brief Writes data to the console with output processing.
+ *
+ * @param[in] d Points to the data to write.
+ * @param[in] size Number of bytes to write.
+ *
+ * @return The number of bytes written, or -EINTR.
+ */
+static ssize_t basic_tty_output(const char *d, size_t size)
+{
 #if CONFIG_CHROUT_LF_HANDLING
-            __chrout('\n');
+    return tty_tx_write(d, size);
 #else
-            __chrout('\r');
-            __chrout('\n');
+    ssize_t result = 0;
+    ssize_t written;
+    size_t len;
+    if ((basic_tty_termios.c_oflag & (OPOST | ONLCR)) != (OPOST | ONLCR))
+        return tty_tx_write(d, size);
+
+    /* Copy runs of characters into the transmit ring, and expand
+     * each LF into a CRLF sequence as we go */
+    while (size > 0) {
+        for (len = 0; len < size && d[len] != '\n'; ++len)
+            ; /* Find the end of the run */
+        if (len > 0) {
+            written = tty_tx_write(d, len);
+            if (written < (ssize_t)len)
+                goto interrupted;
+        }
+        if (len < size) {
+            written = tty_tx_write("\r\n", 2);
+            if (written < 2) {
+                written = 0;
+                goto interrupted;
+            }
+            ++len;
+        }
+        d += len;
+        size -= len;
+        result += len;
+    }
+    return result;
+
+interrupted:
+    if (written > 0)
+        result += written;
+    return result ? result : -EINTR;
 #endif
+}
+
+/**
+ * @brief Echoes input characters back to the console.
+ *
+ * @param[in] s Points to the characters to echo.
+ * @param[in] len Number of characters to echo.
+ *
+ * Nothing is echoed if the target echoes input by itself.
+ */
+static void basic_tty_echo(const char *s, size_t len)
+{
+#if !CONFIG_CHRIN_ECHO
+    basic_tty_output(s, len);
+#else
+    (void)s;
+    (void)len;
 #endif
+}
+
+/**
+ * @brief Gets the next input character and applies input processing.
+ *
+ * @return The character, -EINTR if the wait was interrupted, or -1 at
+ * the end of the input.
+ */
+static int basic_tty_input(void)
+{
+    int c = basic_tty_getc();
+    if (c == '\r' && (basic_tty_termios.c_iflag & ICRNL))
+        c = '\n';
+    return c;
+}
+
+/**
+ * @brief Discards the line that is currently being edited.
+ */
+static void basic_tty_line_reset(void)
+{
+    basic_tty_line_len = 0;
+    basic_tty_line_posn = 0;
+    basic_tty_line_done = 0;
+}
+
+/**
+ * @brief Reads and edits input characters in canonical mode until
+ * the line is complete.
+ *
+ * @return Zero if the line is complete, or -EINTR.
+ */
+static int basic_tty_edit_line(void)
+{
+    tcflag_t lflag;
+    uint8_t len;
+    char ch;
+    int c;
+    while (!basic_tty_line_done) {
+        c = basic_tty_input();
+        if (c < 0) {
+            if (c == -EINTR)
+                return c;
+            basic_tty_line_done = 1; /* End of input */
             break;
         }
-        d[result++] = c;
-#if !CONFIG_CHRIN_ECHO
-        if (c == '\b' || c == 0x7F) {
-            __chrout('\b');
-            __chrout(' ');
-            __chrout('\b');
-        } else {
-            __chrout(c);
+        ch = (char)c;
+        lflag = basic_tty_termios.c_lflag;
+        len = basic_tty_line_len;
+        if (ch == basic_tty_termios.c_cc[VERASE] || ch == '\b') {
+            /* Erase the last character */
+            if (len > 0) {
+                --len;
+                if ((lflag & (ECHO | ECHOE)) == (ECHO | ECHOE))
+                    basic_tty_echo("\b \b", 3);
+            }
+        } else if (ch == basic_tty_termios.c_cc[VKILL]) {
+            /* Erase the entire line */
+            if ((lflag & (ECHO | ECHOK)) == (ECHO | ECHOK)) {
+                while (len > 0) {
+                    basic_tty_echo("\b \b", 3);
+                    --len;
+                }
+            }
+            len = 0;
+        } else if (ch == basic_tty_termios.c_cc[VEOF]) {
+            /* Return the line as-is, or end of file if it is empty */
+            basic_tty_line_done = 1;
+        } else if (ch == '\n') {
+            /* End of the line.  There is always room for the newline. */
+            basic_tty_line[len++] = ch;
+            basic_tty_line_done = 1;
+            if (lflag & (ECHO | ECHONL))
+                basic_tty_echo(&ch, 1);
+        } else if (len < (CONFIG_TTY_LINE_MAX - 1)) {
+            /* Add the character to the line if there is room */
+            basic_tty_line[len++] = ch;
+            if (lflag & ECHO)
+                basic_tty_echo(&ch, 1);
         }
+        basic_tty_line_len = len;
+    }
+    return 0;
+}
+
+static ssize_t basic_tty_read(struct file *file, void *data, size_t size)
+{
+    char *d = (char *)data;
+    size_t result;
+    int c;
+    (void)file;
+    if (!size)
+        return 0;
+
+    if (basic_tty_termios.c_lflag & ICANON) {
+        /* Wait for a complete line and then return as much of it as
+         * will fit.  The rest is returned by the next read. */
+        c = basic_tty_edit_line();
+        if (c < 0)
+            return c;
+        result = basic_tty_line_len - basic_tty_line_posn;
+        if (result > size)
+            result = size;
+        memcpy(d, basic_tty_line + basic_tty_line_posn, result);
+        basic_tty_line_posn += (uint8_t)result;
+        if (basic_tty_line_posn >= basic_tty_line_len)
+            basic_tty_line_reset();
+        return result;
+    }
+
+    /* Non-canonical mode: wait for the first character and then return
+     * whatever else is available without waiting */
+    result = 0;
+    c = basic_tty_input();
+    while (c >= 0) {
+        d[result++] = (char)c;
+        if (basic_tty_termios.c_lflag & ECHO)
+            basic_tty_echo(d + result - 1, 1);
+        if (result >= size)
+            break;
+#if CONFIG_CHROUT_NO_WAIT
+        c = __chrin_no_wait();
+        if (c == '\r' && (basic_tty_termios.c_iflag & ICRNL))
+            c = '\n';
+#else
+        break;
 #endif
-        --size;
     }
+    if (!result && c == -EINTR)
+        return c;
     return result;
 }
 
 static ssize_t basic_tty_write(struct file *file, const void *data, size_t size)
 {
-    const char *d = (const char *)data;
-    int result = 0;
     (void)file;
-    while (size > 0) {
-        char c = *d++;
-#if CONFIG_CHROUT_LF_HANDLING
-        __chrout(c);
-#else
-        if (c != '\n') {
-            __chrout(c);
-        } else {
-            __chrout('\r');
-            __chrout('\n');
-        }
+    return basic_tty_output((const char *)data, size);
+}
+
+static int basic_tty_ioctl(struct file *file, int request, void *arg)
+{
+    const struct termios *t = (const struct termios *)arg;
+    (void)file;
+    switch (request) {
+    case TCGETS:
+        memcpy(arg, &basic_tty_termios, sizeof(struct termios));
+        return 0;
+
+    case TCSETSF:
+    case TCSETSW:
+        /* Wait for the output to drain before changing the settings,
+         * and discard pending input if requested */
+        tty_tx_drain();
+        if (request == TCSETSF) {
+            basic_tty_line_reset();
+#if CONFIG_CHROUT_NO_WAIT
+            while (__chrin_no_wait() >= 0)
+                ; /* Discard the character */
 #endif
-        ++result;
-        --size;
+        }
+        /* Fall through */
+
+    case TCSETS:
+        /* Any partial line is discarded when switching modes */
+        if ((basic_tty_termios.c_lflag ^ t->c_lflag) & ICANON)
+            basic_tty_line_reset();
+        memcpy(&basic_tty_termios, t, sizeof(struct termios));
+        return 0;
     }
-    return result;
+    return -EINVAL;
 }
 
 static ssize_t raw_tty_read(struct file *file, void *data, size_t size)
@@ -89,33 +322,29 @@ static ssize_t raw_tty_read(struct file *file, void *data, size_t size)
         if (ch < 0)
             return 0; /* No character available */
     } else {
-        ch = __chrin();
+        ch = basic_tty_getc();
     }
 #else
     (void)file;
-    ch = __chrin();
+    ch = basic_tty_getc();
 #endif
+    if (ch == -EINTR)
+        return ch;
     *((char *)data) = (char)ch;
     return 1;
 }
 
 static ssize_t raw_tty_write(struct file *file, const void *data, size_t size)
 {
-    const char *d = (const char *)data;
-    int result = size;
     (void)file;
-    while (size > 0) {
-        char c = *d++;
-        __chrout(c);
-        --size;
-    }
-    return result;
+    return tty_tx_write(data, size);
 }
 
 static struct file_operations const basic_tty_operations = {
     .close = file_close_default,
     .read = basic_tty_read,
     .write = basic_tty_write,
+    .ioctl = basic_tty_ioctl,
     file_op_lseek_default
 };
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include "drivers/tty/ttyring.h"
+#include <mosnix/target.h>
+#include <errno.h>
+#include <string.h>
+
+#if defined(CONFIG_CONSOLE_BASIC_TTY)
+
+uint8_t tty_tx_buffer[CONFIG_TTY_TX_RING_SIZE];
+uint8_t volatile tty_tx_in;
+uint8_t volatile tty_tx_out;
+uint8_t volatile tty_tx_waiting;
+struct sem tty_tx_sem = SEM_INITIALIZER(tty_tx_sem, 0);
+struct sem tty_rx_sem = SEM_INITIALIZER(tty_rx_sem, 0);
+
+ssize_t tty_tx_write(const void *data, size_t size)
+{
+    const uint8_t *d = (const uint8_t *)data;
+    ssize_t result = 0;
+    uint8_t in, space;
+    size_t len;
+    while (size > 0) {
+        /* How much space is left before we catch up with "tty_tx_out"? */
+        in = tty_tx_in;
+        space = (uint8_t)(tty_tx_out - in - 1) & TTY_TX_MASK;
+        if (!space) {
+            /* The ring is full, so wait for the target to drain it.
+             * Set the waiting flag before checking again so that
+             * we cannot miss the signal. */
+            tty_tx_waiting = 1;
+            tty_tx_start();
+            if (tty_tx_out != (uint8_t)((in + 1) & TTY_TX_MASK))
+                continue;
+            if (sem_wait(&tty_tx_sem) < 0)
+                return result ? result : -EINTR;
+            continue;
+        }
+
+        /* Copy as much as we can up to the end of the buffer */
+        if (space > CONFIG_TTY_TX_RING_SIZE - in)
+            space = CONFIG_TTY_TX_RING_SIZE - in;
+        len = (size < space) ? size : space;
+        memcpy(tty_tx_buffer + in, d, len);
+        tty_tx_in = (uint8_t)(in + len) & TTY_TX_MASK;
+        d += len;
+        size -= len;
+        result += len;
+    }
+    tty_tx_start();
+    return result;
+}
+
+int tty_tx_drain(void)
+{
+    int err;
+    while (tty_tx_in != tty_tx_out) {
+        tty_tx_waiting = 1;
+        tty_tx_start();
+        if (tty_tx_in == tty_tx_out)
+            break;
+        err = sem_wait(&tty_tx_sem);
+        if (err < 0)
+            return err;
+    }
+    return 0;
+}
+
+#endif /* CONFIG_CONSOLE_BASIC_TTY */
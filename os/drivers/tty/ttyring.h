@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_DRIVERS_TTY_TTYRING_H
+#define MOSNIX_DRIVERS_TTY_TTYRING_H
+
+#include <mosnix/attributes.h>
+#include <mosnix/config.h>
+#include <mosnix/sem.h>
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_TTY_TX_RING_SIZE < 2 || CONFIG_TTY_TX_RING_SIZE > 256 || \
+        (CONFIG_TTY_TX_RING_SIZE & (CONFIG_TTY_TX_RING_SIZE - 1)) != 0
+#error "CONFIG_TTY_TX_RING_SIZE must be a power of two between 2 and 256"
+#endif
+
+/**
+ * @brief Mask for wrapping positions in the console's transmit ring.
+ */
+#define TTY_TX_MASK ((uint8_t)(CONFIG_TTY_TX_RING_SIZE - 1))
+
+/**
+ * @brief Console transmit ring buffer.
+ *
+ * The ring is empty when "tty_tx_in" and "tty_tx_out" are the same, and
+ * full when "tty_tx_in" is one position behind "tty_tx_out".  The kernel
+ * adds bytes at "tty_tx_in" and the target removes them at "tty_tx_out".
+ */
+extern uint8_t tty_tx_buffer[CONFIG_TTY_TX_RING_SIZE];
+
+/**
+ * @brief Position in "tty_tx_buffer" to add the next byte at.
+ */
+extern uint8_t volatile tty_tx_in;
+
+/**
+ * @brief Position in "tty_tx_buffer" to transmit the next byte from.
+ */
+extern uint8_t volatile tty_tx_out;
+
+/**
+ * @brief Non-zero if a process is waiting for space in the ring.
+ *
+ * The target clears this and signals "tty_tx_sem" with sem_signal_isr()
+ * once the ring has drained to half full or less.
+ */
+extern uint8_t volatile tty_tx_waiting;
+
+/**
+ * @brief Semaphore that processes wait on when the ring is full.
+ */
+extern struct sem tty_tx_sem;
+
+/**
+ * @brief Semaphore that the target signals with sem_signal_isr() when
+ * it receives a byte from the console.
+ */
+extern struct sem tty_rx_sem;
+
+/**
+ * @brief Writes data to the console's transmit ring.
+ *
+ * @param[in] data Points to the data to write.
+ * @param[in] size Number of bytes to write.
+ *
+ * @return The number of bytes that were written, or -EINTR if the
+ * process was interrupted before anything could be written.
+ *
+ * The calling process will block if the ring is full.
+ */
+ssize_t tty_tx_write(const void *data, size_t size);
+
+/**
+ * @brief Waits until everything in the console's transmit ring has
+ * been transmitted.
+ *
+ * @return Zero on success, or -EINTR if the wait was interrupted.
+ */
+int tty_tx_drain(void);
+
+/**
+ * @brief Starts transmitting the contents of the ring if the target's
+ * transmitter is idle.
+ *
+ * This is provided by the target.
+ */
+ATTR_LEAF void tty_tx_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
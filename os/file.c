@@ -96,7 +96,9 @@ int file_open(const char *path, int flags, mode_t mode)
     /* Perform backend-specific open tasks and set the operation table */
     error = inode->op->open(file);
     if (error < 0) {
-        file_deref(file);
+        /* There is no operations table yet, so close it manually */
+        file_close_default(file);
+        file->count = 0;
         return error;
     }
 
@@ -116,63 +118,63 @@ int sys_open(struct sys_open_s *args)
     return file_open(args->path, args->flags, mode);
 }
 
-int sys_close(struct sys_close_s *args)
+int sys_close(int fd)
 {
     /* Get the file descriptor structure */
-    struct file *file = file_get(args->fd);
+    struct file *file = file_get(fd);
     if (!file)
         return -EBADF;
 
     /* Remove the file descriptor from the current process */
-    current_proc->fd[args->fd] = 0;
+    current_proc->fd[fd] = 0;
 
     /* Dereference the file descriptor, which will actually close it
      * if this is the last copy in use by any process. */
     return file_deref(file);
 }
 
-int sys_read(struct sys_read_s *args)
+int sys_read(int fd, void *data, size_t size)
 {
     ssize_t result;
 
     /* Get the file descriptor structure */
-    struct file *file = file_get(args->fd);
+    struct file *file = file_get(fd);
     if (!file)
         return -EBADF;
 
     /* The buffer pointer must not be NULL if the read size is non-zero  */
-    if (!(args->data) && args->size > 0)
+    if (!data && size > 0)
         return -EFAULT;
 
     /* Add a reference to the file in case the read function blocks */
     file_ref(file);
 
     /* Perform the read using the back-end implementation */
-    result = file->op->read(file, args->data, args->size);
+    result = file->op->read(file, data, size);
 
     /* Dereference the file and return */
     file_deref(file);
     return result;
 }
 
-int sys_write(struct sys_write_s *args)
+int sys_write(int fd, const void *data, size_t size)
 {
     ssize_t result;
 
     /* Get the file descriptor structure */
-    struct file *file = file_get(args->fd);
+    struct file *file = file_get(fd);
     if (!file)
         return -EBADF;
 
     /* The buffer pointer must not be NULL if the write size is non-zero  */
-    if (!(args->data) && args->size > 0)
+    if (!data && size > 0)
         return -EFAULT;
 
     /* Add a reference to the file in case the write function blocks */
     file_ref(file);
 
     /* Perform the write using the back-end implementation */
-    result = file->op->write(file, args->data, args->size);
+    result = file->op->write(file, data, size);
 
     /* Dereference the file and return */
     file_deref(file);
@@ -247,19 +249,18 @@ static int sys_dup_scan(int oldfd, int newfd)
     return -EMFILE;
 }
 
-int sys_dup(struct sys_dup_s *args)
+int sys_dup(int oldfd)
 {
-    return sys_dup_scan(args->oldfd, 0);
+    return sys_dup_scan(oldfd, 0);
 }
 
-int sys_dup2(struct sys_dup2_s *args)
+int sys_dup2(int oldfd, int newfd)
 {
-    int newfd = args->newfd;
     struct file *file;
     struct file *file2;
 
     /* Get the file descriptor to be duplicated */
-    file = file_get(args->oldfd);
+    file = file_get(oldfd);
     if (!file)
         return -EBADF;
 
@@ -268,7 +269,7 @@ int sys_dup2(struct sys_dup2_s *args)
         return -EBADF;
 
     /* If the new file descriptor is the same as the old, nothing to do */
-    if (newfd == args->oldfd)
+    if (newfd == oldfd)
         return newfd;
 
     /* Add a reference to the descriptor to be duplicated */
@@ -327,6 +328,19 @@ int sys_fcntl(struct sys_fcntl_s *args)
     return -EINVAL;
 }
 
+int sys_ioctl(int fd, int request, void *arg)
+{
+    /* Get the file descriptor structure */
+    struct file *file = file_get(fd);
+    if (!file)
+        return -EBADF;
+
+    /* Only devices with an ioctl handler can be controlled */
+    if (!(file->op->ioctl))
+        return -ENOTTY;
+    return file->op->ioctl(file, request, arg);
+}
+
 /* Default implementations of the file operations */
 
 int file_close_default(struct file *file)
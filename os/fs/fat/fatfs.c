@@ -13,6 +13,7 @@
 #include <mosnix/file.h>
 #include <mosnix/proc.h>
 #include <mosnix/attributes.h>
+#include <mosnix/kmalloc.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <string.h>
@@ -25,6 +26,16 @@
 /* Forward declaration */
 extern struct inode_operations const fatfs_operations;
 
+/** Pool of information blocks for inodes and open files */
+KMALLOC_POOL(fatfs_info_pool, fatfs_inode_info, CONFIG_NUM_FATFS_INFO);
+
+/**
+ * @brief Marker in an inode's "extents" field to indicate that the
+ * extent map could not be built and the cluster chain should be used.
+ */
+static struct fatfs_extent const fatfs_no_extents;
+#define FATFS_NO_EXTENTS ((struct fatfs_extent *)&fatfs_no_extents)
+
 /**
  * @brief Initializes a fatfs_inode_info structure when opening a
  * file or directory.
@@ -39,29 +50,90 @@ static uint8_t fatfs_info_new
     (struct fatfs_inode_info *info, uint32_t cluster, uint32_t size)
 {
     info->first_cluster = info->cluster = cluster;
+    info->extent = NULL;
+    info->run_left = 0;
     info->size = size;
+    info->offset = 0;
     if ((info->block = sd_cluster_to_block(cluster)) == 0) {
-        return 0;
+        /* Empty files do not have any clusters allocated to them */
+        return cluster == 0 && size == 0;
     }
-    info->offset = 0;
-    info->blocks_left = sd_info.cluster_size;
     return 1;
 }
 
 /**
- * @brief Prepare to read from a file or directory cluster.
+ * @brief Builds the extent map for a regular file's cluster chain.
+ *
+ * @param[in] cluster First cluster in the file.
+ * @param[in] size Size of the file in bytes.
+ *
+ * @return The extent map, or NULL if the file is empty, is too fragmented,
+ * or there is insufficient memory to hold the map.
+ */
+ATTR_NOINLINE static struct fatfs_extent *fatfs_build_extents
+    (uint32_t cluster, uint32_t size)
+{
+    struct fatfs_extent map[CONFIG_FATFS_MAX_EXTENTS + 1];
+    struct fatfs_extent *extent = map;
+    struct fatfs_extent *extents;
+    uint32_t clusters;
+    uint32_t next;
+    size_t map_size;
+
+    /* Empty files don't have any clusters */
+    if (!cluster || !size) {
+        return 0;
+    }
+
+    /* Only walk as many clusters as are needed to hold the file's data.
+     * This also protects us against loops in the cluster chain. */
+    clusters = ((size - 1) >> (sd_info.cluster_shift + 9)) + 1;
+    extent->start = cluster;
+    extent->length = 1;
+    while (--clusters > 0) {
+        next = fat_get_next_cluster(cluster);
+        if (!next) {
+            /* Chain is shorter than the file size says it should be */
+            break;
+        }
+        if (next != (cluster + 1) || extent->length == 0xFFFF) {
+            /* Start a new run of clusters */
+            if (extent == &(map[CONFIG_FATFS_MAX_EXTENTS - 1])) {
+                /* Too fragmented, so follow the chain instead */
+                return 0;
+            }
+            ++extent;
+            extent->start = next;
+            extent->length = 0;
+        }
+        ++(extent->length);
+        cluster = next;
+    }
+
+    /* Terminate the map and copy it into user space RAM */
+    ++extent;
+    extent->start = 0;
+    extent->length = 0;
+    map_size = ((size_t)(extent - map) + 1) * sizeof(struct fatfs_extent);
+    extents = kmalloc_user_alloc(map_size);
+    if (extents) {
+        memcpy(extents, map, map_size);
+    }
+    return extents;
+}
+
+/**
+ * @brief Advances to the next block in a file or directory if the
+ * current block has been fully read.
  *
  * @param[in,out] info The information structure for the file.
- * @param[out] data Returns a pointer to the next data byte.
  *
- * @return 0 at EOF, greater than 0 for the number of bytes that are
- * available to be read, or a negative error code.
+ * @return 0 at EOF, 1 if there is data left in the current block,
+ * or a negative error code.
  */
-static int fatfs_info_read_prepare
-    (struct fatfs_inode_info *info, const void **data)
+static int fatfs_info_next_block(struct fatfs_inode_info *info)
 {
     uint32_t block = info->block;
-    uint16_t offset;
 
     /* Did we already reach EOF previously? */
     if (block == 0) {
@@ -69,10 +141,33 @@ static int fatfs_info_read_prepare
     }
 
     /* Do we need to advance to the next block or cluster? */
-    offset = info->offset;
-    if (offset >= SD_BLKSIZE) {
-        uint8_t blocks_left = info->blocks_left - 1;
-        if (blocks_left == 0) {
+    if (info->offset >= SD_BLKSIZE) {
+        /* Clusters are aligned within the data area, so if the next block
+         * is at the start of a cluster then we need to follow the chain. */
+        ++block;
+        if ((((uint8_t)block - (uint8_t)(sd_info.cluster_offset)) &
+                (uint8_t)(sd_info.cluster_size - 1)) != 0) {
+            /* Still within the same cluster */
+        } else if (info->extent) {
+            /* The next cluster in the same run immediately follows on
+             * from the current one, so only move on at the end of a run */
+            if (info->run_left) {
+                --(info->run_left);
+            } else {
+                const struct fatfs_extent *extent = ++(info->extent);
+                if (extent->length == 0) {
+                    /* We are at the end of the extent map */
+                    info->block = 0;
+                    return 0;
+                }
+                info->run_left = extent->length - 1;
+                block = sd_cluster_to_block(extent->start);
+                if (block == 0) {
+                    /* Could not resolve the next cluster to a block */
+                    return -EIO;
+                }
+            }
+        } else {
             /* Advance to the next cluster */
             uint32_t cluster = fat_get_next_cluster(info->cluster);
             info->cluster = cluster;
@@ -86,26 +181,56 @@ static int fatfs_info_read_prepare
                 /* Could not resolve the next cluster to a block */
                 return -EIO;
             }
-            blocks_left = sd_info.cluster_size;
-        } else {
-            /* Advance to the next block in the current cluster */
-            ++block;
         }
         info->block = block;
-        info->blocks_left = blocks_left;
-        offset = info->offset = 0;
+        info->offset = 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Prepare to read from a file or directory cluster.
+ *
+ * @param[in,out] info The information structure for the file.
+ * @param[out] data Returns a pointer to the next data byte.
+ *
+ * @return 0 at EOF, greater than 0 for the number of bytes that are
+ * available to be read, or a negative error code.
+ */
+static int fatfs_info_read_prepare
+    (struct fatfs_inode_info *info, const void **data)
+{
+    uint32_t block;
+    uint8_t *block_data;
+    uint16_t offset;
+    uint8_t read_ahead;
+    int result;
+
+    /* Find the block that contains the next byte */
+    result = fatfs_info_next_block(info);
+    if (result <= 0) {
+        return result;
     }
+    block = info->block;
+    offset = info->offset;
 
-    /* Read the current block into the cache */
-    if (sd_cache_read(block) != 0) {
+    /* Read the current block into the cache.  The rest of the cluster
+     * can be read ahead, and so can the whole run of clusters if we are
+     * following the extent map. */
+    read_ahead = (uint8_t)(sd_info.cluster_size - 1) -
+                 (((uint8_t)block - (uint8_t)(sd_info.cluster_offset)) &
+                  (uint8_t)(sd_info.cluster_size - 1));
+    if (info->extent && info->run_left) {
+        read_ahead = 0xFF;
+    }
+    if (sd_cache_read_sequential(block, read_ahead, &block_data) != 0) {
         /* Failed to read the block.  Most likely cause is that the
          * SD card has an error or it has been removed. */
         return -EIO;
     }
 
     /* Return a pointer to the remaining data in the block */
-    info->offset = offset;
-    *data = sd_info.block + offset;
+    *data = block_data + offset;
     return SD_BLKSIZE - offset;
 }
 
@@ -124,7 +249,7 @@ static int fatfs_info_read_dirent
     int size = fatfs_info_read_prepare(info, &data);
     if (size <= 0) {
         return size;
-    } else if (size <= (int)sizeof(struct fat_dir_entry)) {
+    } else if (size < (int)sizeof(struct fat_dir_entry)) {
         return -EINVAL;
     } else {
         info->offset += sizeof(struct fat_dir_entry);
@@ -133,7 +258,8 @@ static int fatfs_info_read_dirent
     }
 }
 
-static ssize_t fatfs_dir_read(struct file *file, void *data, size_t size)
+static ssize_t fatfs_dir_read_locked
+    (struct file *file, void *data, size_t size)
 {
     struct fatfs_inode_info *info = file->fatfs_info;
     struct dirent *out = (struct dirent *)data;
@@ -160,7 +286,8 @@ static ssize_t fatfs_dir_read(struct file *file, void *data, size_t size)
     return result;
 }
 
-static ssize_t fatfs_file_read(struct file *file, void *data, size_t size)
+static ssize_t fatfs_file_read_locked
+    (struct file *file, void *data, size_t size)
 {
     struct fatfs_inode_info *info = file->fatfs_info;
     ssize_t result = 0;
@@ -176,14 +303,35 @@ static ssize_t fatfs_file_read(struct file *file, void *data, size_t size)
         if (!size)
             break;
 
-        /* How many bytes can be read from the current cluster? */
-        read_size = fatfs_info_read_prepare(info, &file_data);
+        /* Find the block that contains the next byte */
+        read_size = fatfs_info_next_block(info);
         if (read_size < 0) {
             return read_size;
         } else if (!read_size) {
             break;
         }
-        memcpy(d, file_data, read_size);
+
+        if (info->offset == 0 && size >= SD_BLKSIZE) {
+            /* The request covers the whole block, so read it straight
+             * into the caller's buffer rather than copying via the cache */
+            if (sd_cache_read_direct(info->block, d) != 0) {
+                return -EIO;
+            }
+            read_size = SD_BLKSIZE;
+        } else {
+            /* Copy as much as we can out of the cached block */
+            read_size = fatfs_info_read_prepare(info, &file_data);
+            if (read_size < 0) {
+                return read_size;
+            } else if (!read_size) {
+                break;
+            }
+            if ((size_t)read_size > size)
+                read_size = (int)size;
+            memcpy(d, file_data, read_size);
+        }
+        info->offset += read_size;
+        file->posn += read_size;
         d += read_size;
         result += read_size;
         size -= read_size;
@@ -191,9 +339,35 @@ static ssize_t fatfs_file_read(struct file *file, void *data, size_t size)
     return result;
 }
 
+/*
+ * The SD card is locked for the whole of each operation that reads from
+ * it, because the block data returned by the cache is only valid until
+ * another process gets a chance to use the card.
+ */
+
+static ssize_t fatfs_dir_read(struct file *file, void *data, size_t size)
+{
+    ssize_t result = sd_lock();
+    if (result == 0) {
+        result = fatfs_dir_read_locked(file, data, size);
+        sd_unlock();
+    }
+    return result;
+}
+
+static ssize_t fatfs_file_read(struct file *file, void *data, size_t size)
+{
+    ssize_t result = sd_lock();
+    if (result == 0) {
+        result = fatfs_file_read_locked(file, data, size);
+        sd_unlock();
+    }
+    return result;
+}
+
 static int fatfs_close(struct file *file)
 {
-    kmalloc_buf_free(file->fatfs_info);
+    kmalloc_pool_free(&fatfs_info_pool, file->fatfs_info);
     return file_close_default(file);
 }
 
@@ -213,7 +387,11 @@ static struct file_operations const fatfs_file_operations = {
 
 static int fatfs_release(struct inode *inode)
 {
-    kmalloc_buf_free(inode->fatfs_info);
+    if (S_ISREG(inode->mode) &&
+            inode->fatfs_info->extents != FATFS_NO_EXTENTS) {
+        kmalloc_user_free(inode->fatfs_info->extents);
+    }
+    kmalloc_pool_free(&fatfs_info_pool, inode->fatfs_info);
     return 0;
 }
 
@@ -221,16 +399,25 @@ static struct inode *fatfs_create_inode
     (const struct fat_dir_entry *entry, struct inode *parent)
 {
     struct fatfs_inode_info *info;
-    struct inode *inode = inode_alloc(&fatfs_operations);
+    struct inode *inode;
+
+    /* Every field that is used is written below, so there is no need
+     * to clear the inode or the information block when allocating them.
+     * The seek position fields of the information block are only used
+     * by open files and are left uninitialized in the inode. */
+    inode = inode_alloc_raw(&fatfs_operations);
     if (!inode) {
         return 0;
     }
-    info = kmalloc_buf_alloc();
+    info = kmalloc_pool_alloc_raw(&fatfs_info_pool);
     if (!info) {
+        inode->fatfs_info = 0;
+        inode->mode = 0;
         inode_deref(inode);
         return 0;
     }
     inode->fatfs_info = info;
+    info->extents = 0;
 #if CONFIG_ACCESS_UID
     /* Inherit ownership information from the parent directory */
     inode->uid = parent->uid;
@@ -242,6 +429,10 @@ static struct inode *fatfs_create_inode
     info->first_cluster =
         (((uint32_t)(entry->cluster_high)) << 16) | entry->cluster_low;
     info->size = entry->size;
+    if (info->first_cluster == 0 && (entry->attrs & FAT_ATTR_DIRECTORY)) {
+        /* ".." in a top-level directory refers to the root directory */
+        info->first_cluster = FAT_END_CLUSTER;
+    }
     if (entry->attrs & FAT_ATTR_READ_ONLY) {
         inode->mode = 0555;
     } else {
@@ -255,7 +446,7 @@ static struct inode *fatfs_create_inode
     return inode;
 }
 
-static int fatfs_lookup
+static int fatfs_lookup_locked
     (struct inode **inode, struct inode *dir, const char *name, size_t namelen)
 {
     char name83[FAT_NAME_LEN];
@@ -328,7 +519,18 @@ static int fatfs_lookup
     return -ENOENT;
 }
 
-static int fatfs_open(struct file *file)
+static int fatfs_lookup
+    (struct inode **inode, struct inode *dir, const char *name, size_t namelen)
+{
+    int result = sd_lock();
+    if (result == 0) {
+        result = fatfs_lookup_locked(inode, dir, name, namelen);
+        sd_unlock();
+    }
+    return result;
+}
+
+static int fatfs_open_locked(struct file *file)
 {
     struct fatfs_inode_info *info = file->inode->fatfs_info;
     if (S_ISDIR(file->mode)) {
@@ -346,13 +548,13 @@ static int fatfs_open(struct file *file)
         }
 
         /* Create a new information block for the file structure */
-        info = kmalloc_buf_alloc();
+        info = kmalloc_pool_alloc_raw(&fatfs_info_pool);
         if (!info) {
             return -ENOMEM;
         }
         file->fatfs_info = info;
         if (!fatfs_info_new(info, cluster, 0)) {
-            kmalloc_buf_free(info);
+            kmalloc_pool_free(&fatfs_info_pool, info);
             return -EIO;
         }
 
@@ -360,17 +562,33 @@ static int fatfs_open(struct file *file)
         file->op = &fatfs_dir_operations;
         return 0;
     } else if (S_ISREG(file->mode)) {
-        /* Open a regular file */
+        /* Open a regular file, and build the extent map for the inode
+         * if this is the first time that the file has been opened.
+         * If the map cannot be built, then remember that so that later
+         * opens go straight to the cluster chain. */
+        const struct fatfs_extent *extents;
         uint32_t cluster = info->first_cluster;
-        info = kmalloc_buf_alloc();
+        uint32_t size = info->size;
+        if (!info->extents) {
+            info->extents = fatfs_build_extents(cluster, size);
+            if (!info->extents) {
+                info->extents = FATFS_NO_EXTENTS;
+            }
+        }
+        extents = info->extents;
+        info = kmalloc_pool_alloc_raw(&fatfs_info_pool);
         if (!info) {
             return -ENOMEM;
         }
         file->fatfs_info = info;
-        if (!fatfs_info_new(info, cluster, info->size)) {
-            kmalloc_buf_free(info);
+        if (!fatfs_info_new(info, cluster, size)) {
+            kmalloc_pool_free(&fatfs_info_pool, info);
             return -EIO;
         }
+        if (extents != FATFS_NO_EXTENTS) {
+            info->extent = extents;
+            info->run_left = extents->length - 1;
+        }
         file->op = &fatfs_file_operations;
         return 0;
     } else {
@@ -378,6 +596,16 @@ static int fatfs_open(struct file *file)
     }
 }
 
+static int fatfs_open(struct file *file)
+{
+    int result = sd_lock();
+    if (result == 0) {
+        result = fatfs_open_locked(file);
+        sd_unlock();
+    }
+    return result;
+}
+
 /**
  * @brief Operations for the FAT filesystem.
  */
@@ -408,7 +636,7 @@ int fatfs_mount_sd(struct inode *dir)
     if (!root) {
         return -ENOMEM;
     }
-    info = kmalloc_buf_alloc();
+    info = kmalloc_pool_alloc(&fatfs_info_pool);
     if (!info) {
         inode_deref(root);
         return -ENOMEM;
@@ -424,7 +652,12 @@ int fatfs_mount_sd(struct inode *dir)
     root->fatfs_info = info;
 
     /* Detect the presence of the SD card */
-    result = sd_detect();
+    if (sd_lock() == 0) {
+        result = sd_detect();
+        sd_unlock();
+    } else {
+        result = SD_DETECT_NONE;
+    }
 
     /* Attach the FAT root directory to the mount point */
     dir->mode |= S_ISVTX;
@@ -16,8 +16,27 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Run of contiguous clusters in a FAT file.
+ */
+struct fatfs_extent
+{
+    /** First cluster in the run */
+    uint32_t start;
+
+    /** Number of clusters in the run, or zero at the end of the list */
+    uint16_t length;
+};
+
 /**
  * @brief Extra information about a FAT filesystem inode.
+ *
+ * The same structure is used for the inode itself and for each open
+ * file that refers to the inode.  The inode uses "extents" whereas
+ * open files use the seek position fields.  The extent map is built
+ * the first time that the inode is opened.  If that fails, then the
+ * inode records that it has no extent map and every open file follows
+ * the cluster chain instead.
  */
 struct fatfs_inode_info
 {
@@ -27,21 +46,38 @@ struct fatfs_inode_info
     /** Size of the file in bytes */
     uint32_t size;
 
-    /** Current cluster for the seek position */
-    uint32_t cluster;
+    union {
+        /** Extent map for the clusters in a regular file, NULL if the
+         *  extent map has not been built yet, or a marker if the file is
+         *  empty, too fragmented, or there was no memory for the map */
+        struct fatfs_extent *extents;
+
+        /** Current cluster for the seek position, when following the
+         *  cluster chain in the FAT */
+        uint32_t cluster;
+    };
+
+    /** Current extent for the seek position, or NULL if the open file
+     *  is following the cluster chain in the FAT instead */
+    const struct fatfs_extent *extent;
+
+    /** Number of clusters left in the current extent after the
+     *  current cluster */
+    uint16_t run_left;
 
     /** Block number within the current cluster */
     uint32_t block;
 
-    /** Offset within the current block */
-    uint16_t offset : 9;
-
-    /** Number of blocks left until the end of the cluster */
-    uint16_t blocks_left : 7;
+    /** Offset within the current block, which may be SD_BLKSIZE if the
+     *  block has been fully read and the next block has not been found yet */
+    uint16_t offset;
 };
 
-/* Check the size of the "fatfs_inode_info" structure */
-kmalloc_buf_size_check(fatfs_inode_info);
+/**
+ * @brief Pool that information blocks for inodes and open files are
+ * allocated from, if there is an SD card interface.
+ */
+extern struct kmalloc_pool fatfs_info_pool;
 
 /**
  * @brief Initialize the FAT filesystem module.
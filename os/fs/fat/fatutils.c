@@ -55,6 +55,8 @@ ATTR_NOINLINE uint8_t fat_format_name
                 return 0;
             posn = 8;
             dot = 1;
+            --namelen;
+            continue;
         } else if (strchr(invalid_chars, ch) != NULL) {
             /* This character is invalid in a 8.3 filename */
             return 0;
@@ -154,6 +156,7 @@ ATTR_NOINLINE uint8_t fat_convert_dirent
 
 ATTR_NOINLINE uint8_t fat_get(uint32_t cluster, uint32_t *value)
 {
+    uint8_t *block;
     unsigned offset;
 
     /* Bail out if the cluster number is out of range */
@@ -162,13 +165,13 @@ ATTR_NOINLINE uint8_t fat_get(uint32_t cluster, uint32_t *value)
     }
 
     /* Cache the relevant FAT block for reading */
-    if (sd_cache_read(sd_info.fat1 + (cluster >> 7)) != 0) {
+    if (sd_cache_read_fat(sd_info.fat1 + (cluster >> 7), &block) != 0) {
         return 0;
     }
 
     /* Extract the cluster number in the FAT entry */
     offset = cluster & 0x0000007F;
-    *value = ((const uint32_t *)(sd_info.block))[offset] & 0x0FFFFFFFUL;
+    *value = ((const uint32_t *)block)[offset] & 0x0FFFFFFFUL;
     return 1;
 }
 
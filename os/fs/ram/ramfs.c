@@ -22,6 +22,9 @@
 
 static struct inode *root;
 
+/** Pool of directory entries */
+KMALLOC_POOL(ramfs_dirent_pool, ramfs_dirent, CONFIG_NUM_RAMFS_DIRENTS);
+
 static int ramfs_is_dot(const struct ramfs_dirent *dirent)
 {
     if (dirent->namelen != 1)
@@ -50,7 +53,7 @@ static int ramfs_release(struct inode *inode)
             if (!ramfs_is_dot(current) && !ramfs_is_dot_dot(current)) {
                 inode_deref(current->inode);
             }
-            kmalloc_buf_free(current);
+            kmalloc_pool_free(&ramfs_dirent_pool, current);
             current = next;
         }
         if (inode->mode & S_ISVTX) {
@@ -237,8 +240,9 @@ static int ramfs_mknod
         return -ENAMETOOLONG;
     }
 
-    /* Allocate a new directory entry for the child */
-    dirent = kmalloc_buf_alloc();
+    /* Allocate a new directory entry for the child.  All of the fields
+     * are written below, so there is no need to clear it first. */
+    dirent = kmalloc_pool_alloc_raw(&ramfs_dirent_pool);
     if (!dirent) {
         return -ENOMEM;
     }
@@ -246,7 +250,7 @@ static int ramfs_mknod
     /* Allocate a new inode for the child */
     child = inode_alloc(&ramfs_operations);
     if (!child) {
-        kmalloc_buf_free(dirent);
+        kmalloc_pool_free(&ramfs_dirent_pool, dirent);
         return -ENOMEM;
     }
     child->mode = mode;
@@ -260,23 +264,24 @@ static int ramfs_mknod
     dirent->namelen = namelen;
     memcpy(dirent->name, name, namelen);
     dirent->inode = child;
+    dirent->next = NULL;
 
 #if RAMFS_DOT_DIRS
     /* If the child is a directory, also create the "." and ".." entries */
     if (S_ISDIR(mode)) {
         struct ramfs_dirent *dot;
         struct ramfs_dirent *dotdot;
-        dot = kmalloc_buf_alloc();
+        dot = kmalloc_pool_alloc_raw(&ramfs_dirent_pool);
         if (!dot) {
             inode_deref(child);
-            kmalloc_buf_free(dirent);
+            kmalloc_pool_free(&ramfs_dirent_pool, dirent);
             return -ENOMEM;
         }
-        dotdot = kmalloc_buf_alloc();
+        dotdot = kmalloc_pool_alloc_raw(&ramfs_dirent_pool);
         if (!dotdot) {
             inode_deref(child);
-            kmalloc_buf_free(dot);
-            kmalloc_buf_free(dirent);
+            kmalloc_pool_free(&ramfs_dirent_pool, dot);
+            kmalloc_pool_free(&ramfs_dirent_pool, dirent);
             return -ENOMEM;
         }
         dot->namelen = 1;
@@ -287,6 +292,7 @@ static int ramfs_mknod
         dotdot->name[0] = '.';
         dotdot->name[1] = '.';
         dotdot->inode = dir;
+        dotdot->next = NULL;
         child->ramfs_dir = dot;
     }
 #endif
@@ -371,8 +377,8 @@ void ramfs_init(void)
      * The circular references here make it impossible to rmdir the root. */
     struct ramfs_dirent *dot;
     struct ramfs_dirent *dotdot;
-    dot = kmalloc_buf_alloc();
-    dotdot = kmalloc_buf_alloc();
+    dot = kmalloc_pool_alloc(&ramfs_dirent_pool);
+    dotdot = kmalloc_pool_alloc(&ramfs_dirent_pool);
     dot->namelen = 1;
     dot->name[0] = '.';
     dot->inode = root;
@@ -55,9 +55,13 @@ struct ramfs_dirent
     struct ramfs_dirent *next;
 };
 
-/* Check that all RAM filesystem structures fit within a buffer cache entry */
+/* Check that file data fragments fit within a buffer cache entry */
 kmalloc_buf_size_check(ramfs_data);
-kmalloc_buf_size_check(ramfs_dirent);
+
+/**
+ * @brief Pool that directory entries are allocated from.
+ */
+extern struct kmalloc_pool ramfs_dirent_pool;
 
 /**
  * @brief Operations for the RAM filesystem.
@@ -12,6 +12,7 @@
 #include <mosnix/proc.h>
 #include <mosnix/util.h>
 #include <mosnix/printk.h>
+#include <mosnix/kmalloc.h>
 #include <sys/stat.h>
 #include <bits/fcntl.h>
 #include <unistd.h>
@@ -28,10 +29,24 @@ static char symlink_buffer[CONFIG_PATH_MAX] ATTR_SECTION_NOINIT;
 
 #endif
 
+/** Pool of inodes */
+KMALLOC_POOL(inode_pool, inode, CONFIG_NUM_INODES);
+
 ATTR_NOINLINE struct inode *inode_alloc
     (const struct inode_operations *operations)
 {
-    struct inode *inode = kmalloc_buf_alloc();
+    struct inode *inode = kmalloc_pool_alloc(&inode_pool);
+    if (inode) {
+        inode->count = 1;
+        inode->op = operations;
+    }
+    return inode;
+}
+
+ATTR_NOINLINE struct inode *inode_alloc_raw
+    (const struct inode_operations *operations)
+{
+    struct inode *inode = kmalloc_pool_alloc_raw(&inode_pool);
     if (inode) {
         inode->count = 1;
         inode->op = operations;
@@ -44,7 +59,7 @@ ATTR_NOINLINE int inode_deref(struct inode *inode)
     --(inode->count);
     if (inode->count <= 0) {
         int result = inode->op->release(inode);
-        kmalloc_buf_free(inode);
+        kmalloc_pool_free(&inode_pool, inode);
         return result;
     } else {
         return 0;
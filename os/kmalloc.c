@@ -11,11 +11,12 @@
 #include <mosnix/config.h>
 #include <mosnix/util.h>
 #include <sys/queue.h>
+#include <stdint.h>
 #include <string.h>
 
 /* Start and end of user space RAM from the linker script */
-extern void *user_space_ram_start;
-extern void *user_space_ram_end;
+extern char user_space_ram_start[];
+extern char user_space_ram_end[];
 
 /**
  * @brief Generic structure of a buffer cache entry on the free list.
@@ -31,15 +32,33 @@ struct kmalloc_buffer
 kmalloc_buf_size_check(kmalloc_buffer);
 
 /**
- * @brief Block within the user space memory allocation region.
+ * @brief Header for a block within the user space memory allocation region.
+ *
+ * The blocks are laid out back to back across the region.  Each header
+ * records the size of its own block and the size of the block before it,
+ * so that the neighbours on both sides can be found in constant time
+ * when the block is freed.
  */
 struct kmalloc_user_block
 {
-    /** Link to the next block */
-    SLIST_ENTRY(kmalloc_user_block) next;
-
-    /** Size of this block in bytes */
+    /** Size of this block in bytes, including the header.  The low bit is
+     *  set if the block is free. */
     size_t size;
+
+    /** Size of the previous block in bytes, or zero for the first block */
+    size_t prev_size;
+};
+
+/**
+ * @brief Free block within the user space memory allocation region.
+ */
+struct kmalloc_user_free_block
+{
+    /** Block header */
+    struct kmalloc_user_block header;
+
+    /** Links to the other free blocks in the same size class */
+    LIST_ENTRY(kmalloc_user_free_block) link;
 };
 
 /* Storage for the buffer cache in the ".noinit" section */
@@ -49,42 +68,161 @@ static struct kmalloc_buffer buffers[CONFIG_NUM_BUFFERS] ATTR_SECTION_NOINIT;
 SLIST_HEAD(kmalloc_buffer_list, kmalloc_buffer);
 static struct kmalloc_buffer_list free_buffers;
 
-/* User space free block list */
-SLIST_HEAD(kmalloc_user_list, kmalloc_user_block);
-static struct kmalloc_user_list free_blocks;
+/* Number of free buffers, the lowest number of free buffers that there
+ * has been, and the number of allocations that failed */
+static unsigned short free_buffers_count;
+static unsigned short free_buffers_low;
+static unsigned short failed_buffers;
+
+/* User space free block lists, segregated by size class.  Size class N
+ * holds the free blocks whose sizes are between 2^(N+3) and 2^(N+4) - 1,
+ * except for the last class which holds everything that is larger. */
+#define KMALLOC_USER_CLASSES 12
+LIST_HEAD(kmalloc_user_list, kmalloc_user_free_block);
+static struct kmalloc_user_list free_blocks[KMALLOC_USER_CLASSES];
+
+/* Bitmap of the size classes in "free_blocks" that are not empty */
+static uint16_t free_classes;
+
+/* Total size of user space, the number of bytes in free blocks, the
+ * lowest number of free bytes that there has been, and the number of
+ * allocations that failed */
+static size_t user_total;
+static size_t user_free;
+static size_t user_free_low;
+static unsigned short user_failed;
+
+/* Flag in the size of a user block that indicates that it is free */
+#define KMALLOC_USER_FREE 1
+
+/* Alignment of user blocks, which also keeps the allocations aligned */
+#define KMALLOC_USER_ALIGN (sizeof(struct kmalloc_user_block))
 
 /* Minimum user block size, below which it is not worth splitting the block */
-#define KMALLOC_MIN_BLOCK_SIZE 32
+#define KMALLOC_MIN_BLOCK_SIZE \
+    (32 + sizeof(struct kmalloc_user_block))
+
+/* Allocations of this size or larger are placed at the top of the free
+ * block that they are carved out of, and smaller allocations at the bottom.
+ * Program images and caches then grow down from the end of the region and
+ * small objects grow up from the start, which keeps fragmentation down. */
+#define KMALLOC_USER_LARGE 512
+
+/* Get the size of a user block, without the free flag */
+#define kmalloc_user_size(block) \
+    ((block)->size & ~((size_t)KMALLOC_USER_FREE))
+
+/* Get the next block after a user block */
+#define kmalloc_user_next(block) \
+    ((struct kmalloc_user_block *) \
+        (((char *)(block)) + kmalloc_user_size((block))))
+
+/**
+ * @brief Gets the size class for a user block.
+ *
+ * @param[in] size Size of the block in bytes.
+ *
+ * @return The size class index.
+ */
+static uint8_t kmalloc_user_class(size_t size)
+{
+    uint8_t index = 0;
+    size >>= 4;
+    while (size != 0 && index < (KMALLOC_USER_CLASSES - 1)) {
+        size >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief Inserts a block into the free list for its size class.
+ *
+ * @param[in] block The block, which must not have the free flag set.
+ */
+static void kmalloc_user_insert(struct kmalloc_user_block *block)
+{
+    uint8_t index = kmalloc_user_class(block->size);
+    user_free += block->size;
+    block->size |= KMALLOC_USER_FREE;
+    LIST_INSERT_HEAD(&(free_blocks[index]),
+                     (struct kmalloc_user_free_block *)block, link);
+    free_classes |= (uint16_t)(1U << index);
+}
+
+/**
+ * @brief Removes a block from the free list for its size class.
+ *
+ * @param[in] block The block, which must have the free flag set.
+ */
+static void kmalloc_user_remove(struct kmalloc_user_block *block)
+{
+    uint8_t index;
+    block->size &= ~((size_t)KMALLOC_USER_FREE);
+    user_free -= block->size;
+    index = kmalloc_user_class(block->size);
+    LIST_REMOVE((struct kmalloc_user_free_block *)block, link);
+    if (LIST_EMPTY(&(free_blocks[index])))
+        free_classes &= (uint16_t)~(1U << index);
+}
 
 void kmalloc_init(void)
 {
     unsigned index;
     struct kmalloc_user_block *block;
+    struct kmalloc_user_block *end;
+    size_t size;
 
     /* Insert all buffers in the buffer cache into the free list */
     SLIST_INIT(&free_buffers);
     for (index = 0; index < CONFIG_NUM_BUFFERS; ++index) {
         SLIST_INSERT_HEAD(&free_buffers, &(buffers[index]), next);
     }
-
-    /* Initially all of user space is one single unallocated block */
-    block = (struct kmalloc_user_block *)&user_space_ram_start;
-    block->size = ((char *)&user_space_ram_end) -
-                  ((char *)&user_space_ram_start) -
-                  sizeof(struct kmalloc_user_block);
-    SLIST_INIT(&free_blocks);
-    SLIST_INSERT_HEAD(&free_blocks, block, next);
+    free_buffers_count = CONFIG_NUM_BUFFERS;
+    free_buffers_low = CONFIG_NUM_BUFFERS;
+    failed_buffers = 0;
+
+    /* Initially all of user space is one single free block, followed by
+     * an allocated block header to stop coalescing at the end of RAM */
+    for (index = 0; index < KMALLOC_USER_CLASSES; ++index) {
+        LIST_INIT(&(free_blocks[index]));
+    }
+    free_classes = 0;
+    user_free = 0;
+    user_failed = 0;
+    size = user_space_ram_end - user_space_ram_start;
+    size = (size & ~(KMALLOC_USER_ALIGN - 1)) - KMALLOC_USER_ALIGN;
+    block = (struct kmalloc_user_block *)user_space_ram_start;
+    block->size = size;
+    block->prev_size = 0;
+    end = kmalloc_user_next(block);
+    end->size = 0;
+    end->prev_size = size;
+    kmalloc_user_insert(block);
+    user_total = size;
+    user_free_low = size;
 }
 
-ATTR_NOINLINE void *kmalloc_buf_alloc(void)
+ATTR_NOINLINE void *kmalloc_buf_alloc_raw(void)
 {
     struct kmalloc_buffer *buf = SLIST_FIRST(&free_buffers);
     if (buf) {
         SLIST_REMOVE_HEAD(&free_buffers, next);
+        if (--free_buffers_count < free_buffers_low)
+            free_buffers_low = free_buffers_count;
+    } else if (failed_buffers != 0xFFFFU) {
+        ++failed_buffers;
+    }
+    return (void *)buf;
+}
+
+ATTR_NOINLINE void *kmalloc_buf_alloc(void)
+{
+    void *buf = kmalloc_buf_alloc_raw();
+    if (buf) {
         memset(buf, 0, sizeof(struct kmalloc_buffer));
-        return (void *)buf;
     }
-    return 0;
+    return buf;
 }
 
 ATTR_NOINLINE void kmalloc_buf_free(void *buf)
@@ -92,69 +230,146 @@ ATTR_NOINLINE void kmalloc_buf_free(void *buf)
     if (buf) {
         struct kmalloc_buffer *buf2 = (struct kmalloc_buffer *)buf;
         SLIST_INSERT_HEAD(&free_buffers, buf2, next);
+        ++free_buffers_count;
     }
 }
 
-/* The user space memory allocator uses a first-fit strategy */
+ATTR_NOINLINE void *kmalloc_pool_alloc_raw(struct kmalloc_pool *pool)
+{
+    char *obj = pool->free_list;
+    if (obj) {
+        /* Reuse an object that was freed back to the pool */
+        pool->free_list = *((void **)obj);
+    } else if (pool->next < pool->end) {
+        /* Take the next object that has never been used */
+        obj = pool->next;
+        pool->next = obj + pool->size;
+    } else {
+        /* Fall back to the general-purpose buffer cache if possible */
+        obj = pool->fallback ? kmalloc_buf_alloc_raw() : 0;
+        if (!obj && pool->failed != 0xFFFFU)
+            ++(pool->failed);
+        return (void *)obj;
+    }
+    if (--(pool->free) < pool->low)
+        pool->low = pool->free;
+    return (void *)obj;
+}
+
+ATTR_NOINLINE void *kmalloc_pool_alloc(struct kmalloc_pool *pool)
+{
+    void *obj = kmalloc_pool_alloc_raw(pool);
+    if (obj) {
+        /* Objects from the buffer cache fallback are no bigger
+         * than the objects in the pool */
+        memset(obj, 0, pool->size);
+    }
+    return obj;
+}
+
+ATTR_NOINLINE void kmalloc_pool_free(struct kmalloc_pool *pool, void *obj)
+{
+    if (!obj)
+        return;
+    if (((char *)obj) >= pool->start && ((char *)obj) < pool->end) {
+        *((void **)obj) = pool->free_list;
+        pool->free_list = obj;
+        ++(pool->free);
+    } else {
+        /* The object came from the buffer cache */
+        kmalloc_buf_free(obj);
+    }
+}
 
-/* This function is missing from <sys/queue.h> but is more efficient than
- * the standard function SLIST_REMOVE() if we know the previous element. */
-#define SLIST_REMOVE_AFTER(head, prevelm, elm, field) \
-    do { \
-        if ((prevelm)) { \
-            (prevelm)->field.sle_next = (elm)->field.sle_next; \
-        } else { \
-            SLIST_REMOVE_HEAD((head), field); \
-        } \
-    } while (0)
+/* The user space memory allocator uses a segregated fit strategy */
 
 ATTR_NOINLINE void *kmalloc_user_alloc(size_t size)
 {
+    struct kmalloc_user_free_block *free_block;
     struct kmalloc_user_block *block;
     struct kmalloc_user_block *block2;
-    struct kmalloc_user_block *prev;
+    size_t remaining;
+    uint16_t classes;
+    uint8_t index;
 
     /*
      * Round the size up to a multiple of 4 so that allocations are
      * aligned for use with the ".o65" executable file format, which
-     * supports 1, 2, and 4 byte alignment.
+     * supports 1, 2, and 4 byte alignment.  The block header is a
+     * multiple of 4 in size, so the start of the data stays aligned.
      *
      * Note: ".o65" does also allow for 256-byte page alignment but
      * we are not supporting such files at present due to memory wastage.
      */
-    size = (size + 3U) & ~((size_t)3);
-
-    /* Search for the first free block that will fit our allocation */
-    prev = NULL;
-    SLIST_FOREACH(block, &free_blocks, next) {
-        if (block->size >= size) {
-            /* Split the block if the remaining space is significant enough */
-            if ((size - block->size) >= KMALLOC_MIN_BLOCK_SIZE) {
-                block2 = (struct kmalloc_user_block *)
-                    ((char *)(block + 1)) + size;
-                block2->size =
-                    block->size - size - sizeof(struct kmalloc_user_block);
-                SLIST_INSERT_AFTER(block, block2, next);
-                block->size = size;
-            }
-
-            /* Remove the block from the free list */
-            SLIST_REMOVE_AFTER(&free_blocks, prev, block, next);
-
-            /* Return the allocated pointer to the caller */
-            return (void *)(block + 1);
+    if (size > ((size_t)~0) / 2U)
+        goto failed;
+    size = (size + sizeof(struct kmalloc_user_block) +
+            KMALLOC_USER_ALIGN - 1) & ~(KMALLOC_USER_ALIGN - 1);
+    if (size < sizeof(struct kmalloc_user_free_block))
+        size = sizeof(struct kmalloc_user_free_block);
+
+    /* Search the size class for the allocation for the first block that
+     * is big enough, as the blocks in the class may be smaller than the
+     * request.  Failing that, every block in the next non-empty size
+     * class up is guaranteed to be big enough. */
+    index = kmalloc_user_class(size);
+    free_block = LIST_FIRST(&(free_blocks[index]));
+    while (free_block && kmalloc_user_size(&(free_block->header)) < size) {
+        free_block = LIST_NEXT(free_block, link);
+    }
+    if (!free_block) {
+        classes = free_classes >> index;
+        do {
+            classes >>= 1;
+            ++index;
+            if (!classes)
+                goto failed;
+        } while ((classes & 1) == 0);
+        free_block = LIST_FIRST(&(free_blocks[index]));
+    }
+    block = &(free_block->header);
+    kmalloc_user_remove(block);
+
+    /* Split the block if the remaining space is significant enough */
+    remaining = block->size - size;
+    if (remaining >= KMALLOC_MIN_BLOCK_SIZE) {
+        block2 = (struct kmalloc_user_block *)(((char *)block) + remaining);
+        if (size >= KMALLOC_USER_LARGE) {
+            /* Large allocation from the top of the block */
+            block->size = remaining;
+            block2->size = size;
+            block2->prev_size = remaining;
+            kmalloc_user_next(block2)->prev_size = size;
+            kmalloc_user_insert(block);
+            block = block2;
+        } else {
+            /* Small allocation from the bottom of the block */
+            block2 = (struct kmalloc_user_block *)(((char *)block) + size);
+            block->size = size;
+            block2->size = remaining;
+            block2->prev_size = size;
+            kmalloc_user_next(block2)->prev_size = remaining;
+            kmalloc_user_insert(block2);
         }
-        prev = block;
     }
+
+    /* Record the high water mark and then return the allocated
+     * pointer to the caller */
+    if (user_free < user_free_low)
+        user_free_low = user_free;
+    return (void *)(block + 1);
+
+failed:
+    if (user_failed != 0xFFFFU)
+        ++user_failed;
     return 0;
 }
 
 ATTR_NOINLINE void kmalloc_user_free(void *ptr)
 {
     struct kmalloc_user_block *block;
-    struct kmalloc_user_block *current;
-    struct kmalloc_user_block *prev;
-    char *temp;
+    struct kmalloc_user_block *neighbour;
+    size_t size;
 
     /* Bail out if the pointer is NULL */
     if (!ptr)
@@ -162,38 +377,77 @@ ATTR_NOINLINE void kmalloc_user_free(void *ptr)
 
     /* Find the block header */
     block = ((struct kmalloc_user_block *)ptr) - 1;
+    size = block->size;
+
+    /* Combine the block with the next block if it is free */
+    neighbour = kmalloc_user_next(block);
+    if (neighbour->size & KMALLOC_USER_FREE) {
+        kmalloc_user_remove(neighbour);
+        size += neighbour->size;
+    }
 
-    /* Search through the free block list to find where to put it back */
-    prev = NULL;
-    SLIST_FOREACH(current, &free_blocks, next) {
-        if (current > block) {
-            /* Free block needs to be inserted prior to the current item.
-             * First see if we can combine it with the current item. */
-            temp = ((char *)(block + 1)) + block->size;
-            if (((void *)temp) == ((void *)current)) {
-                SLIST_REMOVE_AFTER(&free_blocks, prev, current, next);
-                block->size += sizeof(struct kmalloc_user_block);
-                block->size += current->size;
-            }
-            break;
+    /* Combine the block with the previous block if it is free */
+    if (block->prev_size) {
+        neighbour = (struct kmalloc_user_block *)
+            (((char *)block) - block->prev_size);
+        if (neighbour->size & KMALLOC_USER_FREE) {
+            kmalloc_user_remove(neighbour);
+            size += neighbour->size;
+            block = neighbour;
         }
-        prev = current;
     }
 
-    /* Insert the block into the free list */
-    if (prev) {
-        /* See if we can combine the block with the previous one */
-        temp = ((char *)(prev + 1)) + prev->size;
-        if (((void *)temp) == ((void *)block)) {
-            prev->size += sizeof(struct kmalloc_user_block);
-            prev->size += block->size;
-        } else {
-            SLIST_INSERT_AFTER(prev, block, next);
+    /* Put the combined block back on the free list for its size class */
+    block->size = size;
+    kmalloc_user_next(block)->prev_size = size;
+    kmalloc_user_insert(block);
+}
+
+void kmalloc_buf_info(struct meminfo_pool *info)
+{
+    info->size = sizeof(struct kmalloc_buffer);
+    info->total = CONFIG_NUM_BUFFERS;
+    info->free = free_buffers_count;
+    info->peak = CONFIG_NUM_BUFFERS - free_buffers_low;
+    info->failed = failed_buffers;
+}
+
+void kmalloc_pool_info(const struct kmalloc_pool *pool,
+                       struct meminfo_pool *info)
+{
+    info->size = pool->size;
+    info->total = pool->limit;
+    info->free = pool->free;
+    info->peak = pool->limit - pool->low;
+    info->failed = pool->failed;
+}
+
+void kmalloc_user_info(struct meminfo *info)
+{
+    const struct kmalloc_user_free_block *block;
+    size_t size;
+    size_t largest = 0;
+    unsigned short count = 0;
+    uint8_t index;
+
+    /* Find the largest free block and count the free blocks */
+    for (index = 0; index < KMALLOC_USER_CLASSES; ++index) {
+        LIST_FOREACH(block, &(free_blocks[index]), link) {
+            size = kmalloc_user_size(&(block->header));
+            if (size > largest)
+                largest = size;
+            ++count;
         }
-    } else {
-        /* The free block is now the new head of the list */
-        SLIST_INSERT_HEAD(&free_blocks, block, next);
     }
+    if (largest)
+        largest -= sizeof(struct kmalloc_user_block);
+
+    info->user_total = user_total;
+    info->user_free = user_free;
+    info->user_peak = user_total - user_free_low;
+    info->user_largest = largest;
+    info->user_blocks = count;
+    info->user_failed = user_failed;
 }
 
 ATTR_NOINLINE char **kmalloc_copy_argv(int argc, char **argv)
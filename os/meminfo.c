@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <mosnix/syscall.h>
+#include <mosnix/target.h>
+#include <mosnix/kmalloc.h>
+#include <mosnix/inode.h>
+#include "fs/ram/ramfs.h"
+#include "fs/fat/fatfs.h"
+#include <string.h>
+#include <errno.h>
+
+struct meminfo_pool_name
+{
+    char name[MEMINFO_NAME_MAX];
+    const struct kmalloc_pool *pool;
+};
+
+/** List of the kernel's object pools, after the buffer cache */
+static struct meminfo_pool_name const meminfo_pools[] = {
+    {"inode",   &inode_pool},
+    {"dirent",  &ramfs_dirent_pool},
+#if defined(CONFIG_SD) && defined(CONFIG_SPI)
+    {"fatinfo", &fatfs_info_pool},
+#endif
+};
+
+#define MEMINFO_NUM_POOLS \
+    (1 + sizeof(meminfo_pools) / sizeof(meminfo_pools[0]))
+
+/* Check that there is room for all of the pools in "struct meminfo" */
+typedef char meminfo_pools_check
+    [(MEMINFO_NUM_POOLS <= MEMINFO_MAX_POOLS) * 2 - 1];
+
+int sys_meminfo(struct meminfo *info)
+{
+    uint8_t index;
+    if (!info)
+        return -EFAULT;
+    memset(info, 0, sizeof(struct meminfo));
+    info->num_pools = MEMINFO_NUM_POOLS;
+    memcpy(info->pools[0].name, "buffer", sizeof("buffer"));
+    kmalloc_buf_info(&(info->pools[0]));
+    for (index = 1; index < MEMINFO_NUM_POOLS; ++index) {
+        memcpy(info->pools[index].name, meminfo_pools[index - 1].name,
+               MEMINFO_NAME_MAX);
+        kmalloc_pool_info(meminfo_pools[index - 1].pool,
+                          &(info->pools[index]));
+    }
+    kmalloc_user_info(info);
+    return 0;
+}
@@ -13,6 +13,8 @@
 #include <mosnix/printk.h>
 #include <mosnix/sched.h>
 #include <mosnix/syscall.h>
+#include <mosnix/target.h>
+#include <mosnix/vdata.h>
 #include <bits/fcntl.h>
 #include "drivers/tty/console.h"
 #include <string.h>
@@ -22,12 +24,36 @@
 /** Process table for the kernel */
 static struct proc *process_table[CONFIG_PROC_MAX];
 
+#if CONFIG_STACK_PARTITION
+#if CONFIG_PROC_MAX * CONFIG_RETURN_STACK_SIZE > 224
+#error "Return stack partitions do not fit in the 0x0100 page"
+#endif
+/* Each process slot has its own partition of the 6502 return stack page,
+ * so the initial stack contents are written to the page directly. */
+#define proc_stack(p) ((uint8_t *)0x0100)
+#define proc_stack_top(p) ((p)->pid * CONFIG_RETURN_STACK_SIZE - 1)
+#else
+/* The return stack is copied in from the process block when the
+ * process is switched to. */
+#define proc_stack(p) ((p)->context.stack)
+#define proc_stack_top(p) (CONFIG_RETURN_STACK_SIZE - 1)
+#endif
+
 struct proc * volatile current_proc ATTR_SECTION_ZP;
+uint8_t volatile current_zp ATTR_SECTION_ZP;
 uint8_t volatile in_kernel ATTR_SECTION_ZP;
 
 void proc_init(void)
 {
     current_proc = NULL;
+
+    /* Initialize the kernel data page.  The ticks are initialized by
+     * the target's system tick code if it keeps them up to date. */
+    VDATA->seq = 0;
+    VDATA->flags = CONFIG_VDATA_TICKS ? VDATA_FLAG_TICKS : 0;
+    VDATA->pid = 0;
+    VDATA->ppid = 0;
+    VDATA->realtime = 0;
 }
 
 int proc_create(pid_t ppid, int argc, char **argv, struct proc **proc)
@@ -84,40 +110,71 @@ int proc_create(pid_t ppid, int argc, char **argv, struct proc **proc)
         struct proc *parent = process_table[ppid - 1];
         memcpy(p->cwd, parent->cwd, sizeof(p->cwd));
         p->umask = parent->umask;
+        p->nice = parent->nice;
     } else {
         memcpy(p->cwd, "/root", 6);
         p->umask = S_IWGRP | S_IWOTH; /* 022 */
     }
+    p->base_priority = sched_nice_to_priority(p->nice);
+    p->priority = p->base_priority;
 
     /* Process block is ready to go */
     *proc = p;
     return 0;
 }
 
+struct proc *proc_find(pid_t pid)
+{
+    if (pid == 0)
+        return current_proc;
+    else if (pid < 0 || pid > CONFIG_PROC_MAX)
+        return NULL;
+    else
+        return process_table[pid - 1];
+}
+
 void proc_free(struct proc *proc)
 {
     process_table[proc->pid - 1] = NULL;
+    timer_stop(&(proc->alarm));
     kmalloc_user_free(proc->argv);
     proc->state = PROC_UNUSED;
     kmalloc_user_free(proc);
     /* TODO */
 }
 
+#if CONFIG_STACK_CHECK
+
+void proc_check_stack(const struct proc *proc)
+{
+    /* S points to one below the top of stack, so the stack is full
+     * when S is CONFIG_RETURN_STACK_SIZE below the initial value */
+    uint8_t used = (uint8_t)(proc_stack_top(proc) - proc->context.S);
+    if (used > CONFIG_RETURN_STACK_SIZE) {
+        kputstr("Process 0x");
+        kputhexbyte(proc->pid);
+        kputstr(" overran its return stack - halting!\n");
+        _exit(1);
+    }
+}
+
+#endif
+
 static void proc_push_return_stack(struct proc *p, uintptr_t value)
 {
     uint8_t S = p->context.S - 2;
     /* Return address is the value minus 1 */
     --value;
     /* S points to one below the top of stack, not the top of stack */
-    p->context.stack[S + 1] = (uint8_t)value;
-    p->context.stack[S + 2] = (uint8_t)(value >> 8);
+    proc_stack(p)[S + 1] = (uint8_t)value;
+    proc_stack(p)[S + 2] = (uint8_t)(value >> 8);
     p->context.S = S;
 }
 
 static inline void proc_push_byte(struct proc *p, uint8_t value)
 {
     uint8_t S = p->context.S;
-    p->context.stack[S] = (uint8_t)value;
+    proc_stack(p)[S] = (uint8_t)value;
     p->context.S = S - 1;
 }
 
@@ -149,7 +206,7 @@ int proc_create_internal
     /* Configure the new process so that it will jump to "func"
      * when it starts executing.  If "func" returns, then arrange
      * to perform an "_exit" system call. */
-    p->context.S = CONFIG_RETURN_STACK_SIZE - 1;
+    p->context.S = proc_stack_top(p);
     proc_push_return_stack(p, (uintptr_t)proc_stop);
     proc_push_return_stack(p, ((uintptr_t)func) + 1);
     proc_push_byte(p, 0x00); /* P flags to pass to the new process */
@@ -10,14 +10,38 @@
 #include <mosnix/syscall.h>
 #include <mosnix/printk.h>
 #include <mosnix/attributes.h>
+#include <mosnix/vdata.h>
+#include <mosnix/target.h>
+#include <mosnix/timer.h>
+#include <sys/resource.h>
 #include <errno.h>
 #include <stdlib.h>
 
+#if CONFIG_SCHED_LEVELS < 1 || CONFIG_SCHED_LEVELS > 8
+#error "CONFIG_SCHED_LEVELS must be between 1 and 8"
+#endif
+
+/**
+ * @brief Lists of all runnable processes in the system at each priority
+ * level, including the one that is currently running.
+ */
+static struct run_queue runnable[CONFIG_SCHED_LEVELS];
+
 /**
- * @brief List of all runnable processes in the system, except for the
- * one that is currently running.
+ * @brief Bitmap of the priority levels in "runnable" that are not empty.
  */
-static struct run_queue runnable;
+static uint8_t runnable_levels;
+
+/**
+ * @brief Index of the lowest set bit in a 4-bit value, for finding the
+ * highest priority level with runnable processes in constant time.
+ */
+static uint8_t const lowest_bit[16] = {
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+uint8_t volatile need_resched ATTR_SECTION_ZP;
+uint8_t volatile sched_slice_left;
 
 /**
  * @brief Switches to a different process and continues running it.
@@ -35,42 +59,224 @@ ATTR_LEAF int proc_switch_to(struct proc *proc);
 
 void sched_init(void)
 {
-    TAILQ_INIT(&runnable);
+    uint8_t level;
+    for (level = 0; level < CONFIG_SCHED_LEVELS; ++level)
+        TAILQ_INIT(&(runnable[level]));
+    runnable_levels = 0;
+}
+
+/**
+ * @brief Requests a reschedule if there is a runnable process with a
+ * higher priority than the current process.
+ */
+static void sched_check_priority(void)
+{
+    struct proc *proc = current_proc;
+    if (proc && (runnable_levels & ((1U << proc->priority) - 1U)) != 0)
+        need_resched = 1;
 }
 
 void sched_set_runnable(struct proc *proc)
 {
+    uint8_t level;
     if (proc->state != PROC_RUNNING) {
         proc->state = PROC_RUNNING;
-        TAILQ_INSERT_TAIL(&runnable, proc, qptrs);
+        level = proc->priority;
+        TAILQ_INSERT_TAIL(&(runnable[level]), proc, qptrs);
+        runnable_levels |= (uint8_t)(1U << level);
+        sched_check_priority();
     }
 }
 
 void sched_remove_runnable(struct proc *proc)
 {
+    uint8_t level;
     if (proc->state == PROC_RUNNING) {
         proc->state = PROC_NOT_RUNNING;
-        TAILQ_REMOVE(&runnable, proc, qptrs);
+        level = proc->priority;
+        TAILQ_REMOVE(&(runnable[level]), proc, qptrs);
+        if (TAILQ_EMPTY(&(runnable[level])))
+            runnable_levels &= (uint8_t)~(1U << level);
+    }
+}
+
+/**
+ * @brief Runs the work that interrupts have deferred to the kernel;
+ * expired timers and semaphore signals.
+ */
+static void sched_run_deferred(void)
+{
+    if (timer_pending)
+        timer_run();
+    sem_isr_flush();
+}
+
+void sched_wake(struct proc *proc, int result)
+{
+    struct sem *sem;
+    if (proc->state != PROC_SLEEP)
+        return;
+    sem = proc->wait_sem;
+    if (sem) {
+        TAILQ_REMOVE(&(sem->waiters), proc, qptrs);
+        proc->wait_sem = NULL;
     }
+    proc->context.AX = result;
+    sched_set_runnable(proc);
 }
 
 int schedule(void)
 {
-    /* TODO: This is very basic and probably not what we want */
+    uint8_t levels;
+    uint8_t level;
+    struct proc *proc;
 
-    /* Find a runnable process and schedule it */
-    struct proc *proc = TAILQ_FIRST(&runnable);
-    if (!proc) {
+    /* Wake up any processes that were signalled by interrupts or
+     * timers, and then find the highest priority level that has a
+     * runnable process */
+    for (;;) {
+        sched_run_deferred();
+        levels = runnable_levels;
+        if (levels)
+            break;
+#if CONFIG_SYS_IDLE
+        /* Nothing is runnable, so wait for an interrupt to wake
+         * one of the sleeping processes */
+        sys_idle();
+#else
         /* Nothing is runnable, so the system is dead! */
         kputstr("No runnable processes found - halting!\n");
         _exit(1);
+#endif
     }
-    proc_switch_to(proc);
-    return 0;
+#if CONFIG_SCHED_LEVELS > 4
+    if ((levels & 0x0F) == 0)
+        level = 4 + lowest_bit[levels >> 4];
+    else
+#endif
+        level = lowest_bit[levels & 0x0F];
+    proc = TAILQ_FIRST(&(runnable[level]));
+
+    /* Give the process a full time slice */
+    sched_slice_left = CONFIG_SCHED_TIME_SLICE;
+    need_resched = 0;
+    current_zp = (uint8_t)(uintptr_t)(proc->zp);
+    VDATA->pid = proc->pid;
+    VDATA->ppid = proc->ppid;
+#if CONFIG_STACK_CHECK
+    proc_check_stack(proc);
+#endif
+    return proc_switch_to(proc);
+}
+
+void sched_preempt(void)
+{
+    /* Move the current process to the end of its run queue so that the
+     * other runnable processes at the same level get a turn before it
+     * does.  Any priority boost expires at the end of the time slice. */
+    struct proc *proc = current_proc;
+    if (proc->state == PROC_RUNNING) {
+        sched_remove_runnable(proc);
+        if (proc->priority < proc->base_priority)
+            proc->priority = proc->base_priority;
+        sched_set_runnable(proc);
+    }
+    schedule();
+}
+
+void sched_resched(void)
+{
+    sched_run_deferred();
+    if (need_resched)
+        sched_preempt();
+}
+
+uint8_t sched_nice_to_priority(int nice)
+{
+    return (uint8_t)(((unsigned)(nice - PRIO_MIN) * CONFIG_SCHED_LEVELS) /
+                     (PRIO_MAX - PRIO_MIN + 1));
+}
+
+void sched_set_priority(struct proc *proc, uint8_t priority)
+{
+    if (proc->state == PROC_RUNNING) {
+        sched_remove_runnable(proc);
+        proc->priority = priority;
+        sched_set_runnable(proc);
+    } else {
+        proc->priority = priority;
+    }
+    sched_check_priority();
+}
+
+void sched_boost(struct proc *proc)
+{
+    sched_set_priority(proc, sched_boosted_priority(proc));
 }
 
 int sys_sched_yield(void)
 {
-    /* TODO */
+    sched_preempt();
+    return 0;
+}
+
+/**
+ * @brief Finds the target process for getpriority() or setpriority().
+ *
+ * @param[in] which The type of target, which must be PRIO_PROCESS.
+ * @param[in] who The process identifier, or 0 for the current process.
+ * @param[out] proc Returns the process.
+ *
+ * @return Zero on success or a negative error code.
+ */
+static int sched_find_target(int which, id_t who, struct proc **proc)
+{
+    if (which != PRIO_PROCESS)
+        return -EINVAL;
+    *proc = proc_find(who);
+    if (!(*proc))
+        return -ESRCH;
+    return 0;
+}
+
+int sys_getpriority(struct sys_getpriority_s *args)
+{
+    struct proc *proc;
+    int error = sched_find_target(args->which, args->who, &proc);
+    if (error < 0)
+        return error;
+
+    /* Offset the result so that it cannot be confused with an error */
+    return 20 - proc->nice;
+}
+
+int sys_setpriority(struct sys_setpriority_s *args)
+{
+    struct proc *proc;
+    int prio = args->prio;
+    int error = sched_find_target(args->which, args->who, &proc);
+    if (error < 0)
+        return error;
+
+    /* Clamp the nice value to the valid range */
+    if (prio < PRIO_MIN)
+        prio = PRIO_MIN;
+    else if (prio > PRIO_MAX)
+        prio = PRIO_MAX;
+
+#if CONFIG_ACCESS_UID
+    /* Only root can change other users' processes or raise the priority */
+    if (current_proc->euid != 0) {
+        if (proc->uid != current_proc->euid)
+            return -EPERM;
+        if (prio < proc->nice)
+            return -EACCES;
+    }
+#endif
+
+    /* Move the process to its new priority level */
+    proc->nice = prio;
+    proc->base_priority = sched_nice_to_priority(prio);
+    sched_set_priority(proc, proc->base_priority);
     return 0;
 }
@@ -9,6 +9,7 @@
 #include <mosnix/sem.h>
 #include <mosnix/sched.h>
 #include <mosnix/proc.h>
+#include <mosnix/timer.h>
 #include <errno.h>
 
 /*
@@ -17,12 +18,26 @@
  * the semaphore operations would not act in an atomic manner.
  *
  * The one exception is sem_signal_isr() which may be called from
- * either inside or outside the kernel context.
+ * either inside or outside the kernel context.  It only queues the
+ * semaphore on "sem_isr_list" and the kernel performs the signal later
+ * in sem_isr_flush().
  */
 
+struct sem * volatile sem_isr_list ATTR_SECTION_ZP;
+
+/**
+ * @brief Removes all semaphores from "sem_isr_list" with interrupts
+ * disabled.
+ *
+ * @return The previous contents of "sem_isr_list".
+ */
+ATTR_LEAF struct sem *sem_isr_take(void);
+
 void sem_init(struct sem *sem, sem_value_t init_value)
 {
     sem->value = init_value;
+    sem->isr_queued = 0;
+    sem->isr_next = NULL;
     TAILQ_INIT(&(sem->waiters));
 }
 
@@ -54,10 +69,46 @@ void sem_signal_monitor(struct sem *sem)
         sem_wakeup(sem);
 }
 
-void sem_signal_isr(struct sem *sem)
+void sem_isr_flush(void)
 {
-    /* TODO */
-    (void)sem;
+    struct sem *sem;
+    struct sem *next;
+    if (!sem_isr_list)
+        return;
+    sem = sem_isr_take();
+    while (sem != NULL) {
+        /* Clear the queued flag before the signal so that an interrupt
+         * that arrives in the meantime will queue the semaphore again */
+        next = sem->isr_next;
+        sem->isr_queued = 0;
+        sem_signal_monitor(sem);
+        sem = next;
+    }
+}
+
+/**
+ * @brief Puts the current process to sleep on a semaphore.
+ *
+ * @param[in,out] sem The semaphore to wait on.
+ * @param[in] priority The priority level to wake up at.
+ *
+ * @return 0, -EBUSY, or -EINTR for the result of the wait operation.
+ */
+static int sem_sleep(struct sem *sem, uint8_t priority)
+{
+    /* Semaphore value is zero, so add this process to the waiting list */
+    struct proc *p = current_proc;
+    sched_remove_runnable(p);
+    TAILQ_INSERT_TAIL(&(sem->waiters), p, qptrs);
+    p->wait_sem = sem;
+    p->state = PROC_SLEEP;
+    p->priority = priority;
+
+    /* Ask the scheduler to run something else until it is time to
+     * wake this process up again.  When we are woken, the return
+     * value of schedule() will be 0, -EBUSY, or -EINTR for the
+     * result of the wait operation. */
+    return schedule();
 }
 
 int sem_wait(struct sem *sem)
@@ -68,26 +119,53 @@ int sem_wait(struct sem *sem)
         sem->value = value - 1;
         return 0;
     } else {
-        /* Semaphore value is zero, so add this process to the waiting list */
-        struct proc *p = current_proc;
-        sched_remove_runnable(p);
-        TAILQ_INSERT_TAIL(&(sem->waiters), p, qptrs);
-        p->wait_sem = sem;
-        p->state = PROC_SLEEP;
-
-        /* Ask the scheduler to run something else until it is time to
-         * wake this process up again.  When we are woken, the return
-         * value of schedule() will be 0, -EBUSY, or -EINTR for the
-         * result of the wait operation. */
-        return schedule();
+        return sem_sleep(sem, current_proc->base_priority);
+    }
+}
+
+int sem_wait_interactive(struct sem *sem)
+{
+    sem_value_t value = sem->value;
+    if (value) {
+        /* We were able to acquire the semaphore immediately */
+        sem->value = value - 1;
+        return 0;
+    } else {
+        /* Wake up one level above the base priority */
+        return sem_sleep(sem, sched_boosted_priority(current_proc));
     }
 }
 
+/**
+ * @brief Wakes up a process when its semaphore wait times out.
+ *
+ * @param[in] timer The timer that expired.
+ */
+static void sem_timeout(struct timer *timer)
+{
+    sched_wake((struct proc *)(timer->arg), -EBUSY);
+}
+
 int sem_wait_timed(struct sem *sem, clock_t timeout)
 {
-    /* TODO: handle timeouts */
-    (void)timeout;
-    return sem_wait(sem);
+    struct proc *p = current_proc;
+    struct timer timer;
+    sem_value_t value = sem->value;
+    int result;
+    if (value) {
+        /* We were able to acquire the semaphore immediately */
+        sem->value = value - 1;
+        return 0;
+    } else if (!timeout) {
+        return -EBUSY;
+    } else {
+        /* Sleep until the semaphore is signalled or the timer expires */
+        timer.link.le_prev = NULL;
+        timer_start(&timer, timeout, sem_timeout, p);
+        result = sem_sleep(sem, p->base_priority);
+        timer_stop(&timer);
+        return result;
+    }
 }
 
 void sem_interrupt(struct sem *sem)
@@ -10,9 +10,10 @@
 #include <mosnix/target.h>
 #include <mosnix/inode.h>
 #include <mosnix/attributes.h>
-
-/** Offset that converts monotonic time into real time */
-static long long realtime = 0;
+#include <mosnix/vdata.h>
+#include <mosnix/timer.h>
+#include <mosnix/sched.h>
+#include <errno.h>
 
 int sys_getmonotime(struct sys_getmonotime_s *args)
 {
@@ -22,19 +23,83 @@ int sys_getmonotime(struct sys_getmonotime_s *args)
 
 int sys_getrealtime(struct sys_getrealtime_s *args)
 {
-    *(args->t) = realtime;
+    *(args->t) = VDATA->realtime;
     return 0;
 }
 
 int sys_setrealtime(struct sys_setrealtime_s *args)
 {
-    realtime = args->t;
+    /* The real time offset is stored in the kernel data page so that
+     * user space can read it directly */
+    VDATA->realtime = args->t;
+    ++(VDATA->seq);
     return 0;
 }
 
+/* Number of nanoseconds in a system tick */
+#define NSEC_PER_TICK (1000000000L / TIMER_HZ)
+
+/* Maximum number of seconds for a sleep, to keep the tick count
+ * within the range of the timer wheel */
+#define SLEEP_MAX_SEC 0x7FFFFFL
+
+int sys_nanosleep(const struct timespec *req, struct timespec *rem)
+{
+    clock_t ticks;
+    clock_t left;
+    time_t sec;
+    int result;
+    if (!req)
+        return -EFAULT;
+    sec = req->tv_sec;
+    if (sec < 0 || req->tv_nsec < 0 || req->tv_nsec >= 1000000000L)
+        return -EINVAL;
+    if (sec > SLEEP_MAX_SEC)
+        sec = SLEEP_MAX_SEC;
+
+    /* Round partial ticks up so that we sleep for at least as long
+     * as was requested */
+    ticks = ((clock_t)sec) * TIMER_HZ +
+            (clock_t)((req->tv_nsec + NSEC_PER_TICK - 1) / NSEC_PER_TICK);
+    result = timer_sleep(ticks, &left);
+    if (result < 0 && rem) {
+        rem->tv_sec = (time_t)(left / TIMER_HZ);
+        rem->tv_nsec = (long)(left % TIMER_HZ) * NSEC_PER_TICK;
+    }
+    return result;
+}
+
+/**
+ * @brief Interrupts the wait of a process when its alarm expires.
+ *
+ * @param[in] timer The alarm timer that expired.
+ */
+static void proc_alarm(struct timer *timer)
+{
+    sched_wake((struct proc *)(timer->arg), -EINTR);
+}
+
+int sys_alarm(unsigned int seconds)
+{
+    struct proc *p = current_proc;
+    clock_t left = timer_remaining(&(p->alarm));
+
+    /* Return the number of seconds that were left on the previous
+     * alarm, rounded up */
+    left = (left + TIMER_HZ - 1) / TIMER_HZ;
+    if (left > 0x7FFF)
+        left = 0x7FFF;
+    if (seconds)
+        timer_start(&(p->alarm), ((clock_t)seconds) * TIMER_HZ,
+                    proc_alarm, p);
+    else
+        timer_stop(&(p->alarm));
+    return (int)left;
+}
+
 ATTR_NOINLINE time_t inode_get_mtime(void)
 {
     long long t;
     sys_monoclock(&t);
-    return (time_t)((t + realtime) >> 8);
+    return (time_t)((t + VDATA->realtime) >> 8);
 }
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include <mosnix/timer.h>
+#include <mosnix/sched.h>
+#include <mosnix/syscall.h>
+#include <errno.h>
+
+/*
+ * Timers are kept in a hashed timer wheel.  A timer that expires at
+ * tick N is placed in slot N modulo the number of slots.  On each tick,
+ * only the timers in the slot for that tick need to be checked, and most
+ * slots are empty.
+ *
+ * The system tick interrupt only counts the ticks in "timer_pending".
+ * The timers are processed later by timer_run() when the kernel is in a
+ * position to wake up processes.
+ */
+
+#if CONFIG_TIMER_WHEEL_SIZE < 1 || CONFIG_TIMER_WHEEL_SIZE > 128 || \
+        (CONFIG_TIMER_WHEEL_SIZE & (CONFIG_TIMER_WHEEL_SIZE - 1)) != 0
+#error "CONFIG_TIMER_WHEEL_SIZE must be a power of two between 1 and 128"
+#endif
+
+#define TIMER_WHEEL_MASK (CONFIG_TIMER_WHEEL_SIZE - 1)
+
+LIST_HEAD(timer_list, timer);
+
+/**
+ * @brief Slots in the timer wheel.
+ */
+static struct timer_list timer_wheel[CONFIG_TIMER_WHEEL_SIZE];
+
+/**
+ * @brief Number of ticks that have been processed by timer_run().
+ */
+static clock_t timer_now;
+
+uint8_t volatile timer_pending ATTR_SECTION_ZP;
+uint8_t volatile timer_active ATTR_SECTION_ZP;
+
+/**
+ * @brief Takes a single tick from "timer_pending" with interrupts disabled.
+ *
+ * @return Non-zero if there was a tick to take.
+ */
+ATTR_LEAF uint8_t timer_take_tick(void);
+
+void timer_start(struct timer *timer, clock_t ticks,
+                 timer_func_t func, void *arg)
+{
+    timer_stop(timer);
+
+    /* Ticks that have occurred but not been processed yet are counted
+     * as part of the current time */
+    timer->expires = timer_now + timer_pending + ticks;
+    timer->func = func;
+    timer->arg = arg;
+    LIST_INSERT_HEAD(&(timer_wheel[timer->expires & TIMER_WHEEL_MASK]),
+                     timer, link);
+    ++timer_active;
+}
+
+void timer_stop(struct timer *timer)
+{
+    if (timer_is_running(timer)) {
+        LIST_REMOVE(timer, link);
+        timer->link.le_prev = NULL;
+        --timer_active;
+    }
+}
+
+clock_t timer_remaining(const struct timer *timer)
+{
+    clock_t now;
+    if (!timer_is_running(timer))
+        return 0;
+    now = timer_now + timer_pending;
+    if ((long)(timer->expires - now) <= 0)
+        return 0;
+    return timer->expires - now;
+}
+
+void timer_run(void)
+{
+    struct timer_list expired;
+    struct timer *timer;
+    struct timer *next;
+    while (timer_take_tick()) {
+        ++timer_now;
+
+        /* Move the timers that expire on this tick to a separate list
+         * before calling any of them, because the timer functions may
+         * start or stop other timers in the same slot.  The other timers
+         * in this slot expire on later turns of the wheel. */
+        LIST_INIT(&expired);
+        timer = LIST_FIRST(&(timer_wheel[timer_now & TIMER_WHEEL_MASK]));
+        while (timer != NULL) {
+            next = LIST_NEXT(timer, link);
+            if (timer->expires == timer_now) {
+                LIST_REMOVE(timer, link);
+                LIST_INSERT_HEAD(&expired, timer, link);
+            }
+            timer = next;
+        }
+
+        /* A timer function may stop or restart a timer that is still
+         * on the expired list, so always take the first one */
+        while ((timer = LIST_FIRST(&expired)) != NULL) {
+            timer_stop(timer);
+            timer->func(timer);
+        }
+    }
+}
+
+/**
+ * @brief Wakes up a process when its sleep timer expires.
+ *
+ * @param[in] timer The timer that expired.
+ */
+static void timer_wakeup(struct timer *timer)
+{
+    sched_wake((struct proc *)(timer->arg), 0);
+}
+
+int timer_sleep(clock_t ticks, clock_t *left)
+{
+    struct proc *p = current_proc;
+    struct timer timer;
+    int result;
+    if (!ticks || !p)
+        return 0;
+    timer.link.le_prev = NULL;
+    timer_start(&timer, ticks, timer_wakeup, p);
+    sched_remove_runnable(p);
+    p->state = PROC_SLEEP;
+    result = schedule();
+    if (left)
+        *left = timer_remaining(&timer);
+    timer_stop(&timer);
+    return result;
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include "command.h"
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <errno.h>
+
+/*
+ * Micro-benchmarks for the kernel, timed with the cycle counter of the
+ * "mos-sim" simulator.  Each result is printed on a line of its own
+ * in the form "bench,name,iterations,cycles-per-op".
+ */
+
+#if MOSNIX_TARGET_SIM
+
+/* Cycle counter in the register block of "mos-sim" */
+#define BENCH_CYCLES (*((volatile unsigned long *)0xFFF0))
+
+/* Default number of iterations for each benchmark */
+#define BENCH_ITERATIONS 100
+
+/* Directory tree for timing path lookups */
+#define BENCH_DIR "/tmp/bench"
+
+/* Buffer for read and write benchmarks */
+static char bench_buffer[64];
+
+/* File descriptors for /dev/zero and /dev/null */
+static int bench_zero_fd;
+static int bench_null_fd;
+
+static void bench_empty(void)
+{
+}
+
+static void bench_getpid(void)
+{
+    _getpid();
+}
+
+static void bench_getpid_vdata(void)
+{
+    getpid();
+}
+
+static void bench_getpid_brk(void)
+{
+    syscall_brk(SYS_getpid);
+}
+
+/* The shell is the only runnable process and there is no way to start
+ * another one, so sched_yield() always returns straight back to the
+ * caller.  This times the system call round trip, not a context switch. */
+static void bench_yield_self(void)
+{
+    sched_yield();
+}
+
+static void bench_read_zero_1(void)
+{
+    read(bench_zero_fd, bench_buffer, 1);
+}
+
+static void bench_read_zero_64(void)
+{
+    read(bench_zero_fd, bench_buffer, sizeof(bench_buffer));
+}
+
+static void bench_write_null_1(void)
+{
+    write(bench_null_fd, bench_buffer, 1);
+}
+
+static void bench_write_null_1_stack(void)
+{
+    syscall(SYS_write, bench_null_fd, bench_buffer, 1);
+}
+
+static void bench_write_null_64(void)
+{
+    write(bench_null_fd, bench_buffer, sizeof(bench_buffer));
+}
+
+static void bench_readdir(void)
+{
+    DIR *dir = opendir("/dev");
+    if (dir) {
+        while (readdir(dir) != NULL)
+            ;
+        closedir(dir);
+    }
+}
+
+static void bench_readdir_batch(void)
+{
+    static struct dirent entries[4];
+    static struct sys_read_s reads[4];
+    static struct syscall_op ops[4];
+    unsigned char index;
+    int fd = syscall(SYS_opendir, "/dev");
+    if (fd < 0)
+        return;
+    for (index = 0; index < 4; ++index) {
+        reads[index].fd = fd;
+        reads[index].data = &(entries[index]);
+        reads[index].size = sizeof(struct dirent);
+        ops[index].number = SYS_read;
+        ops[index].args = &(reads[index]);
+    }
+    while (syscall_batch(ops, 4, SYSCALL_BATCH_STOP) == 4 &&
+           ops[3].result == (int)sizeof(struct dirent))
+        ;
+    close(fd);
+}
+
+static void bench_lookup(const char *path)
+{
+    struct stat st;
+    stat(path, &st);
+}
+
+static void bench_lookup_1(void)
+{
+    bench_lookup("/tmp");
+}
+
+static void bench_lookup_3(void)
+{
+    bench_lookup(BENCH_DIR "/a");
+}
+
+static void bench_lookup_6(void)
+{
+    bench_lookup(BENCH_DIR "/a/b/c/d/e");
+}
+
+static void bench_lookup_rel(void)
+{
+    bench_lookup("e");
+}
+
+struct bench_info
+{
+    const char *name;
+    void (*func)(void);
+};
+
+/** List of all benchmarks */
+static struct bench_info const benchmarks[] = {
+    {"getpid",          bench_getpid},
+    {"getpid-brk",      bench_getpid_brk},
+    {"getpid-vdata",    bench_getpid_vdata},
+    {"yield-self",      bench_yield_self},
+    {"read-zero-1",     bench_read_zero_1},
+    {"read-zero-64",    bench_read_zero_64},
+    {"write-null-1",    bench_write_null_1},
+    {"write-null-1-stack", bench_write_null_1_stack},
+    {"write-null-64",   bench_write_null_64},
+    {"readdir-dev",     bench_readdir},
+    {"readdir-dev-batch", bench_readdir_batch},
+    {"lookup-1",        bench_lookup_1},
+    {"lookup-3",        bench_lookup_3},
+    {"lookup-6",        bench_lookup_6},
+    {"lookup-rel",      bench_lookup_rel},
+};
+
+/**
+ * @brief Times a number of calls to a benchmark function.
+ *
+ * @param[in] func The function to call.
+ * @param[in] iterations The number of times to call @a func.
+ *
+ * @return The number of cycles that were taken.
+ */
+static unsigned long bench_time(void (*func)(void), unsigned iterations)
+{
+    unsigned long start = BENCH_CYCLES;
+    while (iterations > 0) {
+        func();
+        --iterations;
+    }
+    return BENCH_CYCLES - start;
+}
+
+/**
+ * @brief Prints a decimal number without padding.
+ *
+ * @param[in] value The value to print.
+ */
+static void bench_print_number(unsigned long value)
+{
+    unsigned long temp = value;
+    unsigned char digits = 1;
+    while (temp >= 10) {
+        temp /= 10;
+        ++digits;
+    }
+    print_number(value, digits);
+}
+
+/**
+ * @brief Creates a directory, ignoring the error if it already exists.
+ *
+ * @param[in] path The path of the directory.
+ *
+ * @return Zero on success, or -1 on error.
+ */
+static int bench_mkdir(const char *path)
+{
+    if (mkdir(path, 0775) < 0 && errno != EEXIST) {
+        print_error(path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sets up the files and directories that are used by the benchmarks.
+ *
+ * @return Zero on success, or -1 on error.
+ */
+static int bench_setup(void)
+{
+    static const char * const dirs[] = {
+        BENCH_DIR, BENCH_DIR "/a", BENCH_DIR "/a/b", BENCH_DIR "/a/b/c",
+        BENCH_DIR "/a/b/c/d", BENCH_DIR "/a/b/c/d/e"
+    };
+    unsigned char index;
+    for (index = 0; index < sizeof(dirs) / sizeof(dirs[0]); ++index) {
+        if (bench_mkdir(dirs[index]) < 0)
+            return -1;
+    }
+    if (chdir(BENCH_DIR "/a/b/c/d") < 0) {
+        print_error(BENCH_DIR);
+        return -1;
+    }
+    bench_zero_fd = open("/dev/zero", O_RDONLY);
+    if (bench_zero_fd < 0) {
+        print_error("/dev/zero");
+        return -1;
+    }
+    bench_null_fd = open("/dev/null", O_WRONLY);
+    if (bench_null_fd < 0) {
+        print_error("/dev/null");
+        close(bench_zero_fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Determine if a benchmark was selected on the command-line.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] argc Number of arguments that were passed to the command.
+ * @param[in] argv List of argument strings.
+ *
+ * @return Non-zero if @a name was selected.
+ */
+static int bench_selected(const char *name, int argc, char **argv)
+{
+    int index;
+    if (optind >= argc)
+        return 1;
+    for (index = optind; index < argc; ++index) {
+        if (!strcmp(argv[index], name))
+            return 1;
+    }
+    return 0;
+}
+
+int cmd_bench(int argc, char **argv)
+{
+    unsigned iterations = BENCH_ITERATIONS;
+    unsigned long overhead, cycles;
+    unsigned char index;
+    const char *arg;
+    int opt;
+
+    /* Parse the command-line options */
+    while ((opt = getopt(argc, argv, "n:")) >= 0) {
+        switch (opt) {
+        case 'n':
+            iterations = 0;
+            for (arg = optarg; *arg >= '0' && *arg <= '9'; ++arg)
+                iterations = iterations * 10 + (*arg - '0');
+            if (*arg != '\0' || iterations == 0) {
+                print_stderr_string("bench: invalid iteration count\n");
+                return 1;
+            }
+            break;
+        default: return 1;
+        }
+    }
+
+    /* Set up the environment for the benchmarks */
+    getcwd(temp_path2, sizeof(temp_path2));
+    if (bench_setup() < 0)
+        return 1;
+
+    /* Measure the cost of the timing loop itself so that it can be
+     * subtracted from the results of the real benchmarks */
+    overhead = bench_time(bench_empty, iterations);
+
+    /* Run the selected benchmarks */
+    for (index = 0; index < sizeof(benchmarks) / sizeof(benchmarks[0]);
+            ++index) {
+        if (!bench_selected(benchmarks[index].name, argc, argv))
+            continue;
+        cycles = bench_time(benchmarks[index].func, iterations);
+        cycles = (cycles > overhead) ? (cycles - overhead) : 0;
+        print_string("bench,");
+        print_string(benchmarks[index].name);
+        print_char(',');
+        bench_print_number(iterations);
+        print_char(',');
+        bench_print_number((cycles + iterations / 2) / iterations);
+        print_nl();
+    }
+
+    /* Clean up */
+    close(bench_zero_fd);
+    close(bench_null_fd);
+    chdir(temp_path2);
+    return 0;
+}
+
+#endif /* MOSNIX_TARGET_SIM */
@@ -21,7 +21,11 @@ struct builtin_command
 
 /** List of all builtin commands, which must be sorted alphanumerically */
 static struct builtin_command const builtins[] = {
+#if MOSNIX_TARGET_SIM
+    {"bench",       cmd_bench},
+#endif
     {"cd",          cmd_chdir},
+    {"free",        cmd_free},
     {"ls",          cmd_ls},
     {"mount",       cmd_mount},
     {"pwd",         cmd_pwd},
@@ -65,7 +65,9 @@ builtin_handler_t cmd_find_builtin(const char *name);
 void cmd_exec(char *line);
 
 /* Command handlers */
+int cmd_bench(int argc, char **argv);
 int cmd_chdir(int argc, char **argv);
+int cmd_free(int argc, char **argv);
 int cmd_ls(int argc, char **argv);
 int cmd_mount(int argc, char **argv);
 int cmd_pwd(int argc, char **argv);
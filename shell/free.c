@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include "command.h"
+#include <sys/meminfo.h>
+
+/* Width of each numeric column */
+#define FREE_WIDTH 7
+
+/**
+ * @brief Prints a name, left-aligned in a column.
+ *
+ * @param[in] name The name to print.
+ */
+static void free_print_name(const char *name)
+{
+    unsigned char len = 0;
+    while (len < MEMINFO_NAME_MAX && name[len] != '\0')
+        print_char(name[len++]);
+    while (len < MEMINFO_NAME_MAX) {
+        print_char(' ');
+        ++len;
+    }
+}
+
+/**
+ * @brief Prints a row of numbers.
+ *
+ * @param[in] name The name for the row.
+ * @param[in] values The values to print.
+ * @param[in] count The number of values.
+ */
+static void free_print_row
+    (const char *name, const unsigned short *values, unsigned char count)
+{
+    free_print_name(name);
+    while (count > 0) {
+        print_number(*values++, FREE_WIDTH);
+        --count;
+    }
+    print_nl();
+}
+
+int cmd_free(int argc, char **argv)
+{
+    static struct meminfo info;
+    unsigned short values[5];
+    unsigned char index;
+    (void)argc;
+    (void)argv;
+
+    if (meminfo(&info) < 0) {
+        print_error("free");
+        return 1;
+    }
+
+    /* Kernel object pools, counted in objects */
+    print_string("pool       size  total   used   peak failed\n");
+    for (index = 0; index < info.num_pools; ++index) {
+        const struct meminfo_pool *pool = &(info.pools[index]);
+        values[0] = pool->size;
+        values[1] = pool->total;
+        values[2] = pool->total - pool->free;
+        values[3] = pool->peak;
+        values[4] = pool->failed;
+        free_print_row(pool->name, values, 5);
+    }
+
+    /* User space memory, counted in bytes */
+    print_string("\n          total   used   peak failed largest blocks\n");
+    free_print_name("user");
+    print_number(info.user_total, FREE_WIDTH);
+    print_number(info.user_total - info.user_free, FREE_WIDTH);
+    print_number(info.user_peak, FREE_WIDTH);
+    print_number(info.user_failed, FREE_WIDTH);
+    print_number(info.user_largest, FREE_WIDTH + 1);
+    print_number(info.user_blocks, FREE_WIDTH);
+    print_nl();
+    return 0;
+}
@@ -80,10 +80,48 @@ static void print_mode(u_char type, mode_t mode)
     }
 }
 
+/* Number of directory entries to read with each entry into the kernel */
+#define LS_BATCH 4
+
+static void print_entry(const struct dirent *entry, unsigned char options)
+{
+    if (options & LS_LONG) {
+        print_mode(entry->d_type, entry->d_mode_np);
+        if (entry->d_type == DT_CHR || entry->d_type == DT_BLK) {
+            dev_t dev = (dev_t)(entry->d_ino);
+            print_number(major(dev), 6);
+            print_char(',');
+            print_number(minor(dev), 4);
+        } else {
+            print_number(entry->d_ino, 11);
+        }
+        /* TODO: print the file modification time */
+        print_char(' ');
+    }
+    print_string(entry->d_name);
+    if (options & LS_CLASSIFY) {
+        if (entry->d_type == DT_DIR) {
+            print_char('/');
+        } else if (entry->d_type == DT_LNK) {
+            print_char('@');
+        } else if (entry->d_type == DT_REG) {
+            /* Detect executable regular files */
+            if (entry->d_mode_np & (S_IXUSR | S_IXGRP | S_IXOTH)) {
+                print_char('*');
+            }
+        }
+    }
+    print_nl();
+}
+
 static int list(const char *spec, unsigned char options)
 {
     int dir = syscall(SYS_opendir, spec);
-    static struct dirent entry;
+    static struct dirent entries[LS_BATCH];
+    static struct sys_read_s reads[LS_BATCH];
+    static struct syscall_op ops[LS_BATCH];
+    unsigned char index;
+    int count;
     if (dir < 0) {
         print_error(spec);
         return 0;
@@ -94,40 +132,37 @@ static int list(const char *spec, unsigned char options)
         print_string(spec);
         print_string(":\n");
     }
+
+    /* Read several directory entries at a time with syscall_batch() */
+    for (index = 0; index < LS_BATCH; ++index) {
+        reads[index].fd = dir;
+        reads[index].data = &(entries[index]);
+        reads[index].size = sizeof(struct dirent);
+        ops[index].number = SYS_read;
+        ops[index].args = &(reads[index]);
+    }
+
     /* TODO: sort the entries in the directory on name */
     errno = 0;
-    while (read(dir, &entry, sizeof(entry)) == (int)sizeof(entry)) {
-        if (entry.d_name[0] == '.' && (options & LS_HIDDEN) == 0) {
-            continue;
-        }
-        if (options & LS_LONG) {
-            print_mode(entry.d_type, entry.d_mode_np);
-            if (entry.d_type == DT_CHR || entry.d_type == DT_BLK) {
-                dev_t dev = (dev_t)(entry.d_ino);
-                print_number(major(dev), 6);
-                print_char(',');
-                print_number(minor(dev), 4);
-            } else {
-                print_number(entry.d_ino, 11);
+    for (;;) {
+        count = syscall_batch(ops, LS_BATCH, SYSCALL_BATCH_STOP);
+        if (count <= 0)
+            break;
+        for (index = 0; index < count; ++index) {
+            if (ops[index].result != (int)sizeof(struct dirent))
+                break;
+            if (entries[index].d_name[0] == '.' &&
+                    (options & LS_HIDDEN) == 0) {
+                continue;
             }
-            /* TODO: print the file modification time */
-            print_char(' ');
+            print_entry(&(entries[index]), options);
         }
-        print_string(entry.d_name);
-        if (options & LS_CLASSIFY) {
-            if (entry.d_type == DT_DIR) {
-                print_char('/');
-            } else if (entry.d_type == DT_LNK) {
-                print_char('@');
-            } else if (entry.d_type == DT_REG) {
-                /* Detect executable regular files */
-                if (entry.d_mode_np & (S_IXUSR | S_IXGRP | S_IXOTH)) {
-                    print_char('*');
-                }
-            }
+        if (index < LS_BATCH) {
+            /* End of the directory or an error occurred */
+            if (index < count && ops[index].result < 0)
+                errno = -(ops[index].result);
+            break;
         }
-        print_nl();
-        errno = 0;
     }
     if (errno != 0) {
         /* An error occurred during readdir() */
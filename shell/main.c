@@ -20,25 +20,22 @@ static char buffer[128];
 
 static int get_line(char *buf, size_t size)
 {
-    size_t posn = 0;
-    int ch;
-    for (;;) {
-        ch = getchar();
-        if (ch < 0) {
-            return 0;
-        } else if (ch == '\r' || ch == '\n') {
-            break;
-        } else if (ch == '\b' || ch == 0x7F) {
-            if (posn > 0) {
-                --posn;
-            }
-        } else if (ch == 0x15) { /* CTRL-U */
-            posn = 0;
-        } else if (ch >= ' ' && posn < (size - 1U)) {
-            buf[posn++] = (char)ch;
-        }
+    /* The kernel's line discipline handles editing and echo, and
+     * returns a whole line at a time */
+    ssize_t len;
+    char ch;
+    print_flush();
+    len = read(0, buf, size - 1);
+    if (len <= 0)
+        return 0;
+    if (buf[len - 1] == '\n') {
+        --len;
+    } else {
+        /* Line is too long for the buffer; discard the rest of it */
+        while (read(0, &ch, 1) == 1 && ch != '\n')
+            ;
     }
-    buf[posn] = '\0';
+    buf[len] = '\0';
     return 1;
 }
 
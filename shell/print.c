@@ -8,66 +8,74 @@
 
 #include "print.h"
 #include <unistd.h>
+#include <stdio_ext.h>
 #include <string.h>
 #include <errno.h>
 #include <mosnix/attributes.h>
 
+/* Standard output goes through the line buffer in libc, and standard
+ * error is unbuffered.  Standard output is flushed before writing to
+ * standard error so that the output appears in the right order. */
+
 ATTR_NOINLINE void print_char(char c)
 {
-    write(1, &c, 1);
+    __putchars(&c, 1);
 }
 
 ATTR_NOINLINE void print_string(const char *s)
 {
     if (s)
-        write(1, s, strlen(s));
+        __putchars(s, strlen(s));
 }
 
 ATTR_NOINLINE void print_nl(void)
 {
-    write(1, "\n", 1);
+    __putchars("\n", 1);
 }
 
 ATTR_NOINLINE void print_flush(void)
 {
-    /* TODO */
+    _flushlbf();
 }
 
 extern unsigned char div10(unsigned long *value);
 
 ATTR_NOINLINE void print_number(unsigned long value, unsigned char size)
 {
+    /* Fill the buffer from the end and then print it in one go */
     char buf[size];
     unsigned char count = 0;
     while (count < 10 && count < size && value != 0) {
-        buf[count] = div10(&value) + '0';
+        buf[size - 1 - count] = div10(&value) + '0';
         ++count;
     }
     if (count == 0) {
-        buf[count++] = '0';
+        buf[size - 1 - count] = '0';
+        ++count;
     }
     while (count < size) {
-        buf[count++] = ' ';
-    }
-    while (count > 0) {
-        --count;
-        print_char(buf[count]);
+        buf[size - 1 - count] = ' ';
+        ++count;
     }
+    __putchars(buf, size);
 }
 
 ATTR_NOINLINE void print_stderr_char(char c)
 {
+    _flushlbf();
     write(2, &c, 1);
 }
 
 ATTR_NOINLINE void print_stderr_string(const char *s)
 {
+    _flushlbf();
     if (s)
         write(2, s, strlen(s));
 }
 
 ATTR_NOINLINE void print_stderr_nl(void)
 {
+    _flushlbf();
     write(2, "\n", 1);
 }
 
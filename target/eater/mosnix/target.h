@@ -24,6 +24,13 @@ extern void sys_monoclock(long long *t);
 /* Get the low 16 bits of the monotonic system clock */
 extern unsigned short sys_clock(void);
 
+/* eater target keeps the ticks in the kernel data page up to date */
+#define CONFIG_VDATA_TICKS 1
+
+/* eater target can wait for the next interrupt when it is idle */
+#define CONFIG_SYS_IDLE 1
+extern void sys_idle(void);
+
 /* eater target uses the basic tty driver as its console */
 #define CONFIG_CONSOLE_BASIC_TTY 1
 /* eater target does not automatically echo */
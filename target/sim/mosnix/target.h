@@ -21,6 +21,24 @@ extern "C" {
 /* Get the monotonic system clock in 1/256'ths of a second */
 extern void sys_monoclock(long long *t);
 
+/* Get the low 16 bits of the monotonic system clock */
+extern unsigned short sys_clock(void);
+
+/* mos-sim target does not have a timer interrupt to keep the ticks
+ * in the kernel data page up to date */
+#define CONFIG_VDATA_TICKS 0
+
+/* mos-sim target can count CPU cycles, for timing below the resolution
+ * of the monotonic system clock.  The simulated CPU runs at 1MHz. */
+#define CONFIG_SYS_CYCLES 1
+#define CONFIG_SYS_CYCLES_HZ 1000000L
+extern void sys_cycles(long long *t);
+
+/* mos-sim target has no interrupts to wake it up when it is idle,
+ * but it can poll the clock until the next timer expires */
+#define CONFIG_SYS_IDLE 1
+extern void sys_idle(void);
+
 /* mos-sim target uses the basic tty driver as its console */
 #define CONFIG_CONSOLE_BASIC_TTY 1
 /* mos-sim echos input characters whether we want it or not */
@@ -34,6 +52,11 @@ extern void __putchar(char c);
 #define __chrin() (getchar())
 #define __chrout(c) (__putchar((c)))
 
+/* mos-sim target emulates an SD card on an SPI interface, backed by an
+ * image of the card that is loaded into memory along with the kernel */
+#define CONFIG_SPI 1
+#define CONFIG_SD 1
+
 #ifdef __cplusplus
 }
 #endif
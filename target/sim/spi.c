@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#include "drivers/spi/spi.h"
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * mos-sim does not have an SPI bus, so we emulate an SD card on the other
+ * end of the bus instead.  The card is backed by an image of a FAT32
+ * filesystem that is loaded into memory between "sim_sd_image_start"
+ * and "sim_sd_image_end" along with the kernel.  See "tools/sdimage".
+ *
+ * Only the commands that are used by the SD card driver for reading are
+ * supported.  Everything else is rejected as an illegal command.
+ */
+
+/* Region of memory that holds the SD card image.  The host benchmarks
+ * in "tools/hostbench" provide their own definitions of these. */
+#ifndef sdemu_image
+extern void *sim_sd_image_start;
+extern void *sim_sd_image_end;
+#define sdemu_image ((const uint8_t *)&sim_sd_image_start)
+#define sdemu_image_blocks \
+    ((uint32_t)(((const uint8_t *)&sim_sd_image_end) - sdemu_image) / 512)
+#endif
+
+/* Emulated card states */
+#define SDEMU_IDLE      0   /**< Waiting for a command */
+#define SDEMU_COMMAND   1   /**< Receiving a command */
+#define SDEMU_READ      2   /**< Reading a single block (CMD17) */
+#define SDEMU_STREAM    3   /**< Reading multiple blocks (CMD18) */
+
+/* Maximum size of a response: gap, R1, gap, token, and 18 bytes of data */
+#define SDEMU_RESPONSE_MAX 22
+
+static struct {
+    /** Non-zero if the chip select is lowered */
+    uint8_t selected;
+
+    /** Non-zero once ACMD41 has finished initializing the card */
+    uint8_t ready;
+
+    /** Non-zero if the last command was CMD55 */
+    uint8_t app_command;
+
+    /** Current state of the emulated card */
+    uint8_t state;
+
+    /** Command bytes that have been received so far */
+    uint8_t command[6];
+
+    /** Number of bytes in "command" */
+    uint8_t command_len;
+
+    /** Response bytes that are queued for the host */
+    uint8_t response[SDEMU_RESPONSE_MAX];
+
+    /** Number of bytes in "response" and the position within it */
+    uint8_t response_len;
+    uint8_t response_posn;
+
+    /** Data block that is being returned for CMD17 or CMD18 */
+    const uint8_t *block;
+
+    /** Position within the data block, including the CRC bytes */
+    uint16_t block_posn;
+
+    /** Next block number for CMD18 */
+    uint32_t next_block;
+
+} sdemu;
+
+/**
+ * @brief Determine if the emulated card is a high capacity card.
+ *
+ * Small images are presented as standard capacity cards so that the
+ * card size in the CSD can describe them exactly.
+ */
+static uint8_t sdemu_sdhc(void)
+{
+    return sdemu_image_blocks >= 1024 && (sdemu_image_blocks % 1024) == 0;
+}
+
+/**
+ * @brief Queues a response byte for the host.
+ */
+static void sdemu_respond(uint8_t value)
+{
+    sdemu.response[sdemu.response_len++] = value;
+}
+
+/**
+ * @brief Starts returning a data block to the host.
+ *
+ * @param[in] blknum The block number to return.
+ *
+ * @return Zero if the block number is out of range.
+ */
+static uint8_t sdemu_start_block(uint32_t blknum)
+{
+    if (blknum >= sdemu_image_blocks)
+        return 0;
+    sdemu.block = sdemu_image + blknum * 512UL;
+    sdemu.block_posn = 0;
+    sdemu.next_block = blknum + 1;
+    return 1;
+}
+
+/**
+ * @brief Executes a command that has been received from the host.
+ */
+static void sdemu_command(void)
+{
+    uint8_t cmd = sdemu.command[0] & 0x3F;
+    uint32_t arg = (((uint32_t)(sdemu.command[1])) << 24) |
+                   (((uint32_t)(sdemu.command[2])) << 16) |
+                   (((uint32_t)(sdemu.command[3])) << 8) |
+                     (uint32_t)(sdemu.command[4]);
+    uint8_t app = sdemu.app_command;
+    uint8_t idle = sdemu.ready ? 0x00 : 0x01;
+    uint32_t size;
+
+    /* Stop any transfer that is in progress.  A stuff byte precedes
+     * the response to CMD12 while a multi-block read is active. */
+    if (sdemu.state == SDEMU_STREAM && cmd == 12)
+        sdemu_respond(0xFF);
+    sdemu.state = SDEMU_IDLE;
+    sdemu.app_command = 0;
+    sdemu.response_len = 0;
+    sdemu.response_posn = 0;
+
+    /* Every response starts with a one byte gap */
+    sdemu_respond(0xFF);
+    if (!app && cmd == 0) {
+        /* Software reset */
+        sdemu.ready = 0;
+        sdemu_respond(0x01);
+    } else if (!app && cmd == 8) {
+        /* Check voltage range, echoing back the check pattern */
+        sdemu_respond(idle);
+        sdemu_respond(0x00);
+        sdemu_respond(0x00);
+        sdemu_respond(sdemu.command[3]);
+        sdemu_respond(sdemu.command[4]);
+    } else if (!app && (cmd == 9 || cmd == 10)) {
+        /* Read the CSD or CID register */
+        sdemu_respond(0x00);
+        sdemu_respond(0xFF);
+        sdemu_respond(0xFE);
+        memset(sdemu.response + sdemu.response_len, 0, 18);
+        if (cmd == 9) {
+            uint8_t *csd = sdemu.response + sdemu.response_len;
+            if (sdemu_sdhc()) {
+                /* Version 2 CSD: size is (C_SIZE + 1) * 512K */
+                size = (sdemu_image_blocks >> 10) - 1;
+                csd[0] = 0x40;
+                csd[7] = (uint8_t)(size >> 16);
+                csd[8] = (uint8_t)(size >> 8);
+                csd[9] = (uint8_t)size;
+            } else {
+                /* Version 1 CSD: READ_BL_LEN = 9, C_SIZE_MULT = 0,
+                 * so the size is (C_SIZE + 1) * 4 blocks. */
+                size = (sdemu_image_blocks >> 2) - 1;
+                csd[5] = 0x09;
+                csd[6] = (uint8_t)(size >> 10);
+                csd[7] = (uint8_t)(size >> 2);
+                csd[8] = (uint8_t)(size << 6);
+            }
+        }
+        sdemu.response_len += 18;
+    } else if (!app && cmd == 12) {
+        /* Stop transmission */
+        sdemu_respond(0x00);
+    } else if (!app && (cmd == 17 || cmd == 18)) {
+        /* Read a single block or multiple blocks */
+        if (!sdemu_sdhc())
+            arg >>= 9;
+        if (sdemu_start_block(arg)) {
+            sdemu_respond(0x00);
+            sdemu_respond(0xFF);
+            sdemu_respond(0xFE);
+            sdemu.state = (cmd == 17) ? SDEMU_READ : SDEMU_STREAM;
+        } else {
+            sdemu_respond(0x40);
+        }
+    } else if (!app && cmd == 55) {
+        /* Application command prefix */
+        sdemu.app_command = 1;
+        sdemu_respond(idle);
+    } else if (!app && cmd == 58) {
+        /* Read OCR */
+        sdemu_respond(idle);
+        sdemu_respond(sdemu_sdhc() ? 0xC0 : 0x80);
+        sdemu_respond(0xFF);
+        sdemu_respond(0x80);
+        sdemu_respond(0x00);
+    } else if (app && cmd == 41) {
+        /* Initialize the card */
+        sdemu.ready = 1;
+        sdemu_respond(0x00);
+    } else {
+        /* Illegal command */
+        sdemu_respond(idle | 0x04);
+    }
+}
+
+/**
+ * @brief Gets the next byte that the card sends to the host.
+ */
+static uint8_t sdemu_next_byte(void)
+{
+    uint8_t value;
+    if (sdemu.response_posn < sdemu.response_len)
+        return sdemu.response[(sdemu.response_posn)++];
+    if (sdemu.state != SDEMU_READ && sdemu.state != SDEMU_STREAM)
+        return 0xFF;
+    if (sdemu.block_posn < 512) {
+        /* Next byte of the data block */
+        return sdemu.block[(sdemu.block_posn)++];
+    }
+    /* Send the two CRC bytes, which are not checked by the driver */
+    value = 0x00;
+    ++(sdemu.block_posn);
+    if (sdemu.block_posn < 514)
+        return value;
+    if (sdemu.state == SDEMU_STREAM) {
+        /* Start the next block in the stream */
+        sdemu.response_len = 0;
+        sdemu.response_posn = 0;
+        if (sdemu_start_block(sdemu.next_block)) {
+            sdemu_respond(0xFF);
+            sdemu_respond(0xFE);
+        } else {
+            /* Out of range error token */
+            sdemu_respond(0x08);
+            sdemu.state = SDEMU_IDLE;
+        }
+    } else {
+        sdemu.state = SDEMU_IDLE;
+    }
+    return value;
+}
+
+/**
+ * @brief Exchanges a byte with the emulated card.
+ */
+static uint8_t sdemu_exchange(uint8_t value)
+{
+    uint8_t result;
+    if (!sdemu.selected)
+        return 0xFF;
+    if (sdemu.command_len > 0 || (value & 0xC0) == 0x40) {
+        /* Part of a command that is being sent to the card.  The card
+         * keeps sending whatever it was sending while the command
+         * is shifted in. */
+        result = sdemu_next_byte();
+        sdemu.command[(sdemu.command_len)++] = value;
+        if (sdemu.command_len == 6) {
+            sdemu.command_len = 0;
+            sdemu_command();
+        }
+        return result;
+    }
+    return sdemu_next_byte();
+}
+
+void spi_init(void)
+{
+    memset(&sdemu, 0, sizeof(sdemu));
+}
+
+void spi_send(const void *data, size_t size)
+{
+    const uint8_t *d = (const uint8_t *)data;
+    while (size > 0) {
+        sdemu_exchange(*d++);
+        --size;
+    }
+}
+
+void spi_send_byte(unsigned char value)
+{
+    sdemu_exchange(value);
+}
+
+void spi_receive(void *data, size_t size)
+{
+    uint8_t *d = (uint8_t *)data;
+    size_t len;
+    while (size > 0) {
+        if (sdemu.selected && sdemu.response_posn >= sdemu.response_len &&
+                (sdemu.state == SDEMU_READ || sdemu.state == SDEMU_STREAM) &&
+                sdemu.block_posn < 512) {
+            /* Copy as much of the data block as we can in one go */
+            len = 512 - sdemu.block_posn;
+            if (len > size)
+                len = size;
+            memcpy(d, sdemu.block + sdemu.block_posn, len);
+            sdemu.block_posn += len;
+            d += len;
+            size -= len;
+        } else {
+            *d++ = sdemu_exchange(0xFF);
+            --size;
+        }
+    }
+}
+
+unsigned char spi_receive_byte(void)
+{
+    return sdemu_exchange(0xFF);
+}
+
+void spi_blank(size_t size)
+{
+    while (size > 0) {
+        sdemu_exchange(0xFF);
+        --size;
+    }
+}
+
+void spi_sdcard_lower_cs(void)
+{
+    sdemu.selected = 1;
+}
+
+void spi_sdcard_raise_cs(void)
+{
+    sdemu.selected = 0;
+    sdemu.command_len = 0;
+}
@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <mosnix/printk.h>
+#include <mosnix/timer.h>
+#include "drivers/tty/ttyring.h"
 
 struct _sim_reg {
   uint8_t clock[4];  // 0
@@ -43,8 +46,105 @@ void _exit(int status)
 
 __attribute__((alias("_exit"))) void _Exit(int status);
 
+// Nominal clock speed of the simulated CPU.
+#define SIM_CPU_HZ 1000000LL
+
+// The simulator's cycle counter is only 32 bits in size, which wraps
+// around after about 71 minutes at 1MHz.  Extend it to 64 bits by
+// counting the number of times that it has wrapped around since the
+// last time it was read.
+static uint32_t sim_cycles_last;
+static uint32_t sim_cycles_wraps;
+
+// Read the 32-bit cycle counter one byte at a time.  The counter keeps
+// running between the byte reads, so a carry out of a lower byte can tear
+// the value.  Read the upper bytes, then the low byte, and then read the
+// upper bytes again; if they have not changed, then the bytes form a
+// consistent snapshot.  Comparing two full reads would never settle
+// because the low byte changes on every instruction.
+static uint32_t sim_read_cycles(void)
+{
+  volatile uint8_t *clock = sim_reg_iface->clock;
+  uint8_t b0, b1, b2, b3;
+  do {
+    b3 = clock[3];
+    b2 = clock[2];
+    b1 = clock[1];
+    b0 = clock[0];
+  } while (b1 != clock[1] || b2 != clock[2] || b3 != clock[3]);
+  return ((uint32_t)b3 << 24) | ((uint32_t)b2 << 16) |
+         ((uint16_t)b1 << 8) | b0;
+}
+
+void sys_cycles(long long *t)
+{
+  uint32_t cycles = sim_read_cycles();
+  if (cycles < sim_cycles_last)
+    ++sim_cycles_wraps;
+  sim_cycles_last = cycles;
+  *t = (((long long)sim_cycles_wraps) << 32) | cycles;
+}
+
 void sys_monoclock(long long *t)
 {
-  // Not implemented on this platform at present.
-  *t = 0;
+  // Convert cycles into 1/256'ths of a second.
+  long long cycles;
+  sys_cycles(&cycles);
+  *t = (cycles * 256) / SIM_CPU_HZ;
+}
+
+unsigned short sys_clock(void)
+{
+  long long t;
+  sys_monoclock(&t);
+  return (unsigned short)t;
+}
+
+// Provided by the kernel's scheduler.
+void sched_tick(void);
+
+// The simulator does not have a timer interrupt, so the cycle counter is
+// polled on entry to every system call to drive the scheduler's time
+// slices instead.  Each tick is 4096 cycles, which is close enough to 256
+// ticks per second.  A process that never performs a system call will
+// not be preempted.
+void sys_tick_poll(void)
+{
+  static uint8_t last;
+  uint8_t now = (uint8_t)(sim_read_cycles() >> 12);
+  while (last != now) {
+    ++last;
+    sched_tick();
+  }
+}
+
+// The only thing that can wake up a sleeping process on the simulator
+// is a timer, so poll the cycle counter until the next tick is pending.
+// If there are no timers, then nothing can ever become runnable again.
+void sys_idle(void)
+{
+  if (!timer_active) {
+    kputstr("No runnable processes found - halting!\n");
+    _exit(1);
+  }
+  while (!timer_pending)
+    sys_tick_poll();
+}
+
+// The simulator's output register accepts bytes immediately, so there is
+// no transmit interrupt.  Drain the whole console transmit ring as soon as
+// the kernel asks for it to be started, and then wake any process that
+// is waiting for space in the same way as an interrupt handler would.
+void tty_tx_start(void)
+{
+  uint8_t out = tty_tx_out;
+  while (out != tty_tx_in) {
+    __putchar(tty_tx_buffer[out]);
+    out = (out + 1) & TTY_TX_MASK;
+  }
+  tty_tx_out = out;
+  if (tty_tx_waiting) {
+    tty_tx_waiting = 0;
+    sem_signal_isr(&tty_tx_sem);
+  }
 }
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 Rhys Weatherley
+#
+# Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+# See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+# information.
+#
+# Usage: runbench.py [options] mos-sim kernel script
+#
+# Boots a kernel in "mos-sim", feeds it the shell commands in "script",
+# and collects the lines of the form "bench,name,iterations,cycles" that
+# are printed by the shell's "bench" command.  The results are written to
+# standard output, and optionally to a file, in CSV format.
+
+import argparse
+import subprocess
+import sys
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run the MOSnix benchmarks under mos-sim.')
+    parser.add_argument('--output', metavar='FILE',
+                        help='write the results to FILE as well as stdout')
+    parser.add_argument('--timeout', type=int, default=600,
+                        help='maximum number of seconds to run for')
+    parser.add_argument('sim', help='path to the mos-sim simulator')
+    parser.add_argument('kernel', help='path to the kernel image')
+    parser.add_argument('script', help='shell commands to run')
+    args = parser.parse_args()
+
+    with open(args.script, 'rb') as script:
+        try:
+            result = subprocess.run([args.sim, '--cmos', args.kernel],
+                                    stdin=script, stdout=subprocess.PIPE,
+                                    stderr=subprocess.STDOUT,
+                                    timeout=args.timeout)
+        except subprocess.TimeoutExpired:
+            sys.stderr.write('runbench: timed out\n')
+            return 1
+    transcript = result.stdout.decode('ascii', errors='replace')
+
+    # Extract the benchmark results from the transcript.
+    results = ['name,iterations,cycles_per_op']
+    for line in transcript.splitlines():
+        line = line.strip()
+        if line.startswith('bench,'):
+            results.append(line[6:])
+    if len(results) == 1:
+        sys.stderr.write(transcript)
+        sys.stderr.write('runbench: no benchmark results were found\n')
+        return 1
+
+    output = '\n'.join(results) + '\n'
+    sys.stdout.write(output)
+    if args.output:
+        with open(args.output, 'w') as file:
+            file.write(output)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
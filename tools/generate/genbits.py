@@ -21,7 +21,7 @@ for line in lines:
     fields = line.strip().split('|')
     fields = [s.strip() for s in fields]
     name = re.sub(r'^_', '', fields[1])
-    name = name.replace('%', '')
+    name = gentools.strip_flags(name)
     print("#define SYS_%s %s" % (name, fields[0]))
 
 gentools.print_footer(cplusplus=False)
@@ -14,6 +14,26 @@ gentools.print_header("", cplusplus=False, include=['<mosnix/syscall.h>'])
 
 print("/* Generated automatically */")
 print("")
+
+# Adapters for calling register-based system calls via the stack.
+for line in lines:
+    if line.startswith('#'):
+        continue
+    fields = line.strip().split('|')
+    fields = [s.strip() for s in fields]
+    if '!' not in fields[1] or len(fields) <= 3 or fields[3] == 'void':
+        continue
+    name = re.sub(r'^_', '', fields[1])
+    name = gentools.strip_flags(name)
+    argNames = []
+    for arg in fields[3:]:
+        argNames.append("args->" + re.findall(r'[A-Za-z0-9_]+$', arg)[0])
+    print("int sys_%s_args(struct sys_%s_s *args)" % (name, name))
+    print("{")
+    print("    return sys_%s(%s);" % (name, ", ".join(argNames)))
+    print("}")
+    print("")
+
 print("void * const SYSCALL_TABLE[128] __attribute__((retain)) = {")
 
 next_syscall = 0
@@ -24,12 +44,15 @@ for line in lines:
     fields = line.strip().split('|')
     fields = [s.strip() for s in fields]
     name = re.sub(r'^_', '', fields[1])
-    name = name.replace('%', '')
+    name = gentools.strip_flags(name)
     number = int(fields[0])
     while next_syscall < number:
         print("    /* %3d */ (void *)sys_notimp," % next_syscall)
         next_syscall = next_syscall + 1
-    print("    /* %3d */ (void *)sys_%s," % (number, name))
+    if '!' in fields[1] and len(fields) > 3 and fields[3] != 'void':
+        print("    /* %3d */ (void *)sys_%s_args," % (number, name))
+    else:
+        print("    /* %3d */ (void *)sys_%s," % (number, name))
     next_syscall = next_syscall + 1
 
 while next_syscall < 127:
@@ -38,5 +61,17 @@ while next_syscall < 127:
 print("    /* %3d */ (void *)sys_notimp" % next_syscall)
 
 print("};")
+print("")
+
+# Table of system calls that take their arguments in registers,
+# which is indexed by the explicit "!N" index in the list.
+print("void * const SYSCALL_REG_TABLE[] __attribute__((retain)) = {")
+index = 0
+for fields in gentools.reg_syscalls(lines):
+    name = re.sub(r'^_', '', fields[1])
+    name = gentools.strip_flags(name)
+    print("    /* %3d */ (void *)sys_%s," % (index, name))
+    index = index + 1
+print("};")
 
 gentools.print_footer(cplusplus=False, endif=False)
@@ -0,0 +1,37 @@
+#!/usr/bin/python
+#
+# Generate the client side library stubs in regsyscall.S for the system
+# calls that pass their arguments in registers.
+
+import gentools
+import sys
+import re
+
+file = open(sys.argv[1], 'r')
+lines = file.readlines()
+file.close()
+
+print(gentools.copyright.replace('/*', ';').replace(' */', ';').replace(' *', ';'))
+print("")
+print("; Generated automatically")
+print("")
+print("; The arguments are already in A:X and RC2..RC5 according to the")
+print("; llvm-mos calling convention, so we only need to load Y with the")
+print("; index into the kernel's register-based system call table.")
+
+index = 0
+for fields in gentools.reg_syscalls(lines):
+    name = gentools.strip_flags(fields[1])
+    if len(fields) > 3 and fields[3] != 'void':
+        mapping = gentools.reg_arg_mapping(name, fields[3:])
+        regs = [arg + " in " + ":".join(r) for arg, r in mapping]
+    else:
+        regs = ["no arguments"]
+    print("")
+    print("; %s: %s" % (name, ", ".join(regs)))
+    print(".global %s" % name)
+    print(".section .text.%s,\"ax\",@progbits" % name)
+    print("%s:" % name)
+    print("  ldy #%d" % (index * 2))
+    print("  jmp __syscall_reg")
+    index = index + 1
@@ -0,0 +1,38 @@
+#!/usr/bin/python
+#
+# Generate the system call argument structures for <bits/sysargs.h>.
+
+import gentools
+import sys
+import re
+
+file = open(sys.argv[1], 'r')
+lines = file.readlines()
+file.close()
+
+gentools.print_header("MOSNIX_BITS_SYSARGS_H", cplusplus=False, include=["<sys/types.h>"])
+
+print("/* Generated automatically */")
+print("")
+
+# The arguments of each system call, in the order that the stack-based
+# interface lays them out.  These are shared by the kernel and by user
+# code that builds arguments for syscall_batch().
+for line in lines:
+    if line.startswith('#'):
+        continue
+    fields = line.strip().split('|')
+    fields = [s.strip() for s in fields]
+    name = re.sub(r'^_', '', fields[1])
+    name = gentools.strip_flags(name)
+    if len(fields) > 3 and fields[3] != 'void':
+        print("struct sys_%s_s {" % name)
+        for field in fields[3:]:
+            if field.startswith(">"):
+                field2 = field[1:].split(' ')
+                field = field2[0] + ' *' + field2[1]
+            print("    %s;" % field)
+        print("};")
+        print("")
+
+gentools.print_footer(cplusplus=False)
@@ -1,3 +1,6 @@
+import re
+import sys
+
 
 copyright = """/*
  * Copyright (c) 2023 Rhys Weatherley
@@ -33,3 +36,104 @@ def print_footer(cplusplus=True, endif=True):
     if endif:
         print("")
         print("#endif")
+
+def strip_flags(name):
+    """Strip the "%" and "!N" flags from a system call name."""
+    return re.sub(r'%|!\d*', '', name)
+
+# Sizes in bytes of the types that may be passed to register-based
+# system calls.  Pointers are always 2 bytes.
+reg_type_sizes = {
+    'char': 1, 'unsigned char': 1, 'u_char': 1, 'uint8_t': 1,
+    'short': 2, 'unsigned short': 2, 'int': 2, 'unsigned int': 2,
+    'size_t': 2, 'ssize_t': 2, 'mode_t': 2, 'pid_t': 2, 'uid_t': 2,
+    'gid_t': 2, 'id_t': 2, 'dev_t': 2,
+    'long': 4, 'unsigned long': 4, 'off_t': 4, 'time_t': 4, 'clock_t': 4
+}
+
+# Registers that the kernel preserves for register-based system calls,
+# in the order that llvm-mos assigns argument bytes to them.
+reg_arg_registers = ['A', 'X', 'rc2', 'rc3', 'rc4', 'rc5']
+
+# Pairs of registers that llvm-mos passes pointer arguments in.
+reg_pointer_pairs = [('rc2', 'rc3'), ('rc4', 'rc5')]
+
+def reg_type_size(name, type):
+    """Get the size of an argument or return type for a register-based
+    system call, or exit with an error if it is not known."""
+    type = re.sub(r'\bconst\b', '', type).strip()
+    if type.endswith('*'):
+        return 2
+    if type not in reg_type_sizes:
+        sys.stderr.write("%s: unknown size for type '%s'\n" % (name, type))
+        sys.exit(1)
+    return reg_type_sizes[type]
+
+def reg_arg_mapping(name, args):
+    """Map the arguments of a register-based system call to the registers
+    that llvm-mos passes them in.  Returns a list of (argname, registers)
+    pairs, or exits with an error if an argument does not fit in the
+    registers that the kernel preserves."""
+    free = list(reg_arg_registers)
+    mapping = []
+    for arg in args:
+        if arg.startswith('>'):
+            sys.stderr.write("%s: result arguments cannot be passed in registers\n" % name)
+            sys.exit(1)
+        match = re.match(r'^(.*?)([A-Za-z0-9_]+)$', arg)
+        type = match.group(1).strip()
+        argname = match.group(2)
+        size = reg_type_size(name, type)
+        regs = None
+        if type.endswith('*'):
+            # Pointers are passed in the next free pair of registers
+            for pair in reg_pointer_pairs:
+                if pair[0] in free and pair[1] in free:
+                    regs = list(pair)
+                    break
+        elif size <= len(free):
+            # Other values are split into bytes in the next free registers
+            regs = free[:size]
+        if regs is None:
+            sys.stderr.write("%s: argument '%s' does not fit in the A, X, and rc2..rc5 registers\n" % (name, argname))
+            sys.exit(1)
+        for reg in regs:
+            free.remove(reg)
+        mapping.append((argname, regs))
+    return mapping
+
+def reg_syscalls(lines):
+    """Get the register-based system calls from the lines of "syscall.txt",
+    in the order of their explicit index in the register system call table.
+
+    The index of each system call is part of the binary interface, so
+    duplicate indices and gaps are rejected.  The arguments and return
+    value are checked to ensure that they fit in registers."""
+    calls = {}
+    for line in lines:
+        if line.startswith('#'):
+            continue
+        fields = line.strip().split('|')
+        fields = [s.strip() for s in fields]
+        if '!' not in fields[1]:
+            continue
+        name = strip_flags(fields[1])
+        match = re.search(r'!(\d*)', fields[1])
+        if not match.group(1):
+            sys.stderr.write("%s: register-based system call has no index\n" % name)
+            sys.exit(1)
+        index = int(match.group(1))
+        if index in calls:
+            sys.stderr.write("%s: register index %d is already used by %s\n" % (name, index, strip_flags(calls[index][1])))
+            sys.exit(1)
+        if fields[2] != 'void' and reg_type_size(name, fields[2]) > 2:
+            sys.stderr.write("%s: return value does not fit in A:X\n" % name)
+            sys.exit(1)
+        if len(fields) > 3 and fields[3] != 'void':
+            reg_arg_mapping(name, fields[3:])
+        calls[index] = fields
+    for index in range(len(calls)):
+        if index not in calls:
+            sys.stderr.write("register index %d is missing; indices must not be reused or renumbered\n" % index)
+            sys.exit(1)
+    return [calls[index] for index in range(len(calls))]
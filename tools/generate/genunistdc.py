@@ -21,8 +21,9 @@ for line in lines:
     fields = line.strip().split('|')
     fields = [s.strip() for s in fields]
     name = fields[1]
-    if name.endswith('%'):
-        # Don't declare this name in "unistd.c".
+    if '%' in name or '!' in name:
+        # Don't declare this name in "unistd.c".  Register-based
+        # system calls have assembly stubs in "regsyscall.S" instead.
         continue
     name = name.replace('%', '')
     returnType = fields[2]
@@ -21,9 +21,10 @@ for line in lines:
     fields = line.strip().split('|')
     fields = [s.strip() for s in fields]
     name = fields[1]
-    if name.endswith('%'):
+    if '%' in name:
         # Don't declare this name in <unistd.h>.
         continue
+    name = gentools.strip_flags(name)
     returnType = fields[2]
     if len(fields) <= 3 or fields[3] == 'void':
         print("extern %s %s(void);" % (returnType, name))
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+/*
+ * Microbenchmarks for the VFS, RAM filesystem, FAT filesystem, and
+ * kernel memory allocators.  This side of the benchmark is compiled
+ * against the MOSnix headers, just like the kernel.
+ */
+
+#include <mosnix/file.h>
+#include <mosnix/inode.h>
+#include <mosnix/kmalloc.h>
+#include <mosnix/syscall.h>
+#include "fs/ram/ramfs.h"
+#include "fs/fat/fatfs.h"
+#include "drivers/sdcard/sdcard.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include "host.h"
+
+extern void stubs_init(void);
+
+/* Number of files to create in the RAM filesystem test directory */
+#define BENCH_RAMFS_FILES 16
+
+/* Paths that are used by the benchmarks */
+#define BENCH_RAMFS_DIR     "/bench"
+#define BENCH_RAMFS_DEEP    "/bench/a/b/c/d"
+#define BENCH_RAMFS_PATH    "/bench/a/b/c/d/file"
+#define BENCH_FAT_DIR       "/mnt/sd"
+#define BENCH_FAT_PATH      "/mnt/sd/sub/deep/data.bin"
+#define BENCH_FAT_BIG       "/mnt/sd/big.bin"
+
+/* Number of live allocations in the allocator churn benchmark */
+#define BENCH_CHURN_SLOTS 16
+
+/**
+ * @brief Information about a running benchmark.
+ */
+struct bench
+{
+    /** Name of the benchmark */
+    const char *name;
+
+    /** Start time in nanoseconds */
+    uint64_t start;
+
+    /** Number of operations that were performed */
+    unsigned long ops;
+};
+
+/**
+ * @brief Starts a benchmark.
+ *
+ * @param[out] bench The benchmark information to fill in.
+ * @param[in] name Name of the benchmark.
+ *
+ * @return Non-zero if the benchmark should be run.
+ */
+static int bench_start(struct bench *bench, const char *name)
+{
+    if (!host_selected(name))
+        return 0;
+    bench->name = name;
+    bench->ops = 0;
+    bench->start = host_time_ns();
+    return 1;
+}
+
+/**
+ * @brief Ends a benchmark and reports the results.
+ *
+ * @param[in] bench The benchmark information.
+ */
+static void bench_end(const struct bench *bench)
+{
+    uint64_t elapsed = host_time_ns() - bench->start;
+    host_printf("%-16s %10lu ops %12.1f ns/op\n", bench->name, bench->ops,
+                bench->ops ? (double)elapsed / bench->ops : 0.0);
+}
+
+/**
+ * @brief Reports a failure in a benchmark.
+ *
+ * @param[in] name Name of the benchmark or operation.
+ * @param[in] path Path that the operation failed on.
+ * @param[in] error Error code.
+ *
+ * @return Always returns 1.
+ */
+static int bench_fail(const char *name, const char *path, int error)
+{
+    host_printf("%s: %s: error %d\n", name, path, error);
+    return 1;
+}
+
+/**
+ * @brief Creates a file or directory in the RAM filesystem.
+ *
+ * @param[in] path Path to create.
+ * @param[in] mode Mode for the new inode.
+ *
+ * @return Zero on success, or a negative error code.
+ */
+static int bench_create(const char *path, mode_t mode)
+{
+    struct inode *inode;
+    int error = inode_lookup_path(&inode, path, O_CREAT | O_EXCL, mode, 1);
+    if (error >= 0)
+        inode_deref(inode);
+    return error;
+}
+
+/**
+ * @brief Sets up the filesystems for the benchmarks.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_setup(void)
+{
+    static const char * const dirs[] = {
+        "/mnt", BENCH_FAT_DIR, BENCH_RAMFS_DIR, "/bench/a", "/bench/a/b",
+        "/bench/a/b/c", BENCH_RAMFS_DEEP
+    };
+    char name[32];
+    struct inode *dir;
+    uint8_t index;
+    int error;
+
+    kmalloc_init();
+    ramfs_init();
+    fatfs_init();
+    file_init();
+    stubs_init();
+
+    /* Create the RAM filesystem test tree */
+    for (index = 0; index < sizeof(dirs) / sizeof(dirs[0]); ++index) {
+        error = bench_create(dirs[index], S_IFDIR | 0755);
+        if (error < 0)
+            return bench_fail("mkdir", dirs[index], error);
+    }
+    for (index = 0; index < BENCH_RAMFS_FILES; ++index) {
+        strcpy(name, BENCH_RAMFS_DIR "/file00");
+        name[sizeof(BENCH_RAMFS_DIR) + 4] += index / 10;
+        name[sizeof(BENCH_RAMFS_DIR) + 5] += index % 10;
+        error = bench_create(name, S_IFREG | 0644);
+        if (error < 0)
+            return bench_fail("create", name, error);
+    }
+    error = bench_create(BENCH_RAMFS_PATH, S_IFREG | 0644);
+    if (error < 0)
+        return bench_fail("create", BENCH_RAMFS_PATH, error);
+
+    /* Mount the SD card */
+    error = inode_lookup_path(&dir, BENCH_FAT_DIR, 0, S_IFDIR, 1);
+    if (error < 0)
+        return bench_fail("lookup", BENCH_FAT_DIR, error);
+    error = fatfs_mount_sd(dir);
+    inode_deref(dir);
+    if (error != 0)
+        return bench_fail("mount", BENCH_FAT_DIR, error);
+    return 0;
+}
+
+/**
+ * @brief Closes a file descriptor.
+ *
+ * @param[in] fd The file descriptor to close.
+ */
+static void bench_close(int fd)
+{
+    sys_close(fd);
+}
+
+/**
+ * @brief Benchmarks looking up a path.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] path Path to look up.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_lookup(const char *name, const char *path)
+{
+    struct bench bench;
+    struct inode *inode;
+    unsigned long count;
+    int error;
+    if (!bench_start(&bench, name))
+        return 0;
+    for (count = 0; count < hostbench_iterations; ++count) {
+        error = inode_lookup_path(&inode, path, 0, S_IFREG, 1);
+        if (error < 0)
+            return bench_fail(name, path, error);
+        inode_deref(inode);
+        ++(bench.ops);
+    }
+    bench_end(&bench);
+    return 0;
+}
+
+/**
+ * @brief Benchmarks scanning all entries in a directory.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] path Path of the directory to scan.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_scan(const char *name, const char *path)
+{
+    struct bench bench;
+    struct dirent entry;
+    struct file *file;
+    unsigned long count;
+    ssize_t size;
+    int fd;
+    if (!bench_start(&bench, name))
+        return 0;
+    for (count = 0; count < hostbench_iterations; ++count) {
+        fd = file_open(path, O_RDONLY, S_IFDIR);
+        if (fd < 0)
+            return bench_fail(name, path, fd);
+        file = file_get(fd);
+        while ((size = file->op->read(file, &entry, sizeof(entry))) > 0)
+            ++(bench.ops);
+        file_put(file);
+        bench_close(fd);
+        if (size < 0)
+            return bench_fail(name, path, (int)size);
+    }
+    bench_end(&bench);
+    return 0;
+}
+
+/**
+ * @brief Reads a file from start to end.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] path Path of the file to read.
+ * @param[in] chunk Number of bytes to read at a time, up to 4096.
+ * @param[in,out] ops Incremented for each read request.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_read_file
+    (const char *name, const char *path, size_t chunk, unsigned long *ops)
+{
+    static unsigned char buffer[4096];
+    struct file *file;
+    ssize_t size;
+    int fd;
+    fd = file_open(path, O_RDONLY, S_IFREG);
+    if (fd < 0)
+        return bench_fail(name, path, fd);
+    file = file_get(fd);
+    while ((size = file->op->read(file, buffer, chunk)) > 0)
+        ++(*ops);
+    file_put(file);
+    bench_close(fd);
+    if (size < 0)
+        return bench_fail(name, path, (int)size);
+    return 0;
+}
+
+/**
+ * @brief Benchmarks reading a file from start to end.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] path Path of the file to read.
+ * @param[in] chunk Number of bytes to read at a time.
+ *
+ * @return Zero on success, or non-zero on failure.
+ *
+ * Each operation is a single read request.  Reading a whole file is a
+ * lot of operations, so the file is only read once every 16 iterations.
+ */
+static int bench_read(const char *name, const char *path, size_t chunk)
+{
+    struct bench bench;
+    unsigned long count;
+    if (!bench_start(&bench, name))
+        return 0;
+    for (count = 0; count < hostbench_iterations; count += 16) {
+        if (bench_read_file(name, path, chunk, &(bench.ops)) != 0)
+            return 1;
+    }
+    bench_end(&bench);
+    return 0;
+}
+
+/**
+ * @brief Benchmarks reading a file from start to end once the block
+ * cache is full, and reports the block cache hits and misses.
+ *
+ * @param[in] name Name of the benchmark.
+ * @param[in] path Path of the file to read.
+ * @param[in] chunk Number of bytes to read at a time.
+ *
+ * @return Zero on success, or non-zero on failure.
+ *
+ * Blocks that were read ahead are reported as hits when they are read,
+ * so the misses show how many blocks had to wait for the SD card.
+ */
+static int bench_read_warm(const char *name, const char *path, size_t chunk)
+{
+    struct bench bench;
+    unsigned long count;
+    unsigned long warmup = 0;
+    uint32_t hits;
+    uint32_t misses;
+    if (!host_selected(name))
+        return 0;
+
+    /* Fill every slot in the cache with the blocks of another file */
+    if (bench_read_file(name, BENCH_FAT_PATH, chunk, &warmup) != 0)
+        return 1;
+    hits = sd_info.cache.hits;
+    misses = sd_info.cache.misses;
+
+    bench_start(&bench, name);
+    for (count = 0; count < hostbench_iterations; count += 16) {
+        if (bench_read_file(name, path, chunk, &(bench.ops)) != 0)
+            return 1;
+    }
+    bench_end(&bench);
+    host_printf("%-16s %10lu hits %10lu misses\n", name,
+                (unsigned long)(sd_info.cache.hits - hits),
+                (unsigned long)(sd_info.cache.misses - misses));
+    return 0;
+}
+
+/**
+ * @brief Benchmarks allocating and freeing user space memory blocks
+ * of varying sizes.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_alloc_churn(void)
+{
+    void *slots[BENCH_CHURN_SLOTS] = {0};
+    struct bench bench;
+    unsigned long count;
+    uint32_t seed = 1;
+    uint8_t index;
+    if (!bench_start(&bench, "alloc-churn"))
+        return 0;
+    for (count = 0; count < hostbench_iterations * 16; ++count) {
+        seed = seed * 1103515245UL + 12345UL;
+        index = (seed >> 16) % BENCH_CHURN_SLOTS;
+        if (slots[index]) {
+            kmalloc_user_free(slots[index]);
+            slots[index] = 0;
+        } else {
+            slots[index] = kmalloc_user_alloc(((seed >> 8) & 0x1FF) + 1);
+            if (!slots[index])
+                return bench_fail("alloc-churn", "kmalloc_user_alloc", -ENOMEM);
+        }
+        ++(bench.ops);
+    }
+    for (index = 0; index < BENCH_CHURN_SLOTS; ++index)
+        kmalloc_user_free(slots[index]);
+    bench_end(&bench);
+    return 0;
+}
+
+/**
+ * @brief Benchmarks allocating and freeing kernel buffers.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int bench_buf_churn(void)
+{
+    void *bufs[BENCH_CHURN_SLOTS];
+    struct bench bench;
+    unsigned long count;
+    uint8_t index;
+    if (!bench_start(&bench, "buf-churn"))
+        return 0;
+    for (count = 0; count < hostbench_iterations; ++count) {
+        for (index = 0; index < BENCH_CHURN_SLOTS; ++index) {
+            bufs[index] = kmalloc_buf_alloc();
+            if (!bufs[index])
+                return bench_fail("buf-churn", "kmalloc_buf_alloc", -ENOMEM);
+        }
+        for (index = 0; index < BENCH_CHURN_SLOTS; ++index)
+            kmalloc_buf_free(bufs[BENCH_CHURN_SLOTS - 1 - index]);
+        bench.ops += BENCH_CHURN_SLOTS;
+    }
+    bench_end(&bench);
+    return 0;
+}
+
+int bench_run(void)
+{
+    int failed = 0;
+    if (bench_setup() != 0)
+        return 1;
+    failed |= bench_lookup("lookup-ramfs", BENCH_RAMFS_PATH);
+    failed |= bench_lookup("lookup-fat", BENCH_FAT_PATH);
+    failed |= bench_scan("scan-ramfs", BENCH_RAMFS_DIR);
+    failed |= bench_scan("scan-fat", BENCH_FAT_DIR);
+    failed |= bench_alloc_churn();
+    failed |= bench_buf_churn();
+    failed |= bench_read("read-fat-1", BENCH_FAT_BIG, 1);
+    failed |= bench_read("read-fat-64", BENCH_FAT_BIG, 64);
+    failed |= bench_read("read-fat-512", BENCH_FAT_BIG, 512);
+    failed |= bench_read("read-fat-4096", BENCH_FAT_BIG, 4096);
+    failed |= bench_read_warm("read-fat-warm", BENCH_FAT_BIG, 64);
+    return failed;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+/*
+ * Host side of the benchmarks, compiled against the host's C library.
+ *
+ * Usage: hostbench [-n iterations] image [benchmark ...]
+ *
+ * The image is a FAT32 SD card image from "tools/sdimage/mksdimage.py".
+ * If no benchmarks are named, then all of them are run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+
+/* Size of the user space RAM region for kmalloc_user_alloc().  The kernel
+ * finds this through the "user_space_ram_start" and "user_space_ram_end"
+ * symbols, which the link options point at "hostbench_user_ram". */
+#define HOSTBENCH_USER_RAM_SIZE 32768
+
+char hostbench_user_ram[HOSTBENCH_USER_RAM_SIZE] __attribute__((aligned(16)));
+const uint8_t *hostbench_image;
+uint32_t hostbench_image_blocks;
+unsigned long hostbench_iterations = 10000;
+
+static char **selected;
+static int num_selected;
+
+void host_printf(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+}
+
+uint64_t host_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec) * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int host_selected(const char *name)
+{
+    int index;
+    if (!num_selected)
+        return 1;
+    for (index = 0; index < num_selected; ++index) {
+        if (!strcmp(selected[index], name))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Loads the SD card image.
+ *
+ * @param[in] filename Name of the image file.
+ *
+ * @return Zero on success, or non-zero on failure.
+ */
+static int load_image(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    uint8_t *image;
+    long size;
+    if (!file) {
+        perror(filename);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0 || (size % 512) != 0) {
+        fprintf(stderr, "%s: not an SD card image\n", filename);
+        fclose(file);
+        return 1;
+    }
+    image = (uint8_t *)malloc(size);
+    if (!image || fread(image, 1, size, file) != (size_t)size) {
+        perror(filename);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    hostbench_image = image;
+    hostbench_image_blocks = (uint32_t)(size / 512);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && !strcmp(argv[1], "-n")) {
+        hostbench_iterations = strtoul(argv[2], NULL, 0);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "Usage: hostbench [-n iterations] image "
+                        "[benchmark ...]\n");
+        return 1;
+    }
+    if (load_image(argv[1]) != 0)
+        return 1;
+    selected = argv + 2;
+    num_selected = argc - 2;
+    return bench_run();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef HOSTBENCH_HOST_H
+#define HOSTBENCH_HOST_H
+
+/*
+ * Interface between the kernel side of the benchmark, which is compiled
+ * against the MOSnix headers, and the host side, which is compiled against
+ * the host's C library.  Only basic types can be used here.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Image of the emulated SD card, loaded by the host side.
+ */
+extern const uint8_t *hostbench_image;
+
+/**
+ * @brief Number of 512-byte blocks in the emulated SD card image.
+ */
+extern uint32_t hostbench_image_blocks;
+
+/**
+ * @brief Number of iterations to run each benchmark for.
+ */
+extern unsigned long hostbench_iterations;
+
+/**
+ * @brief Prints a formatted message on the host's standard output.
+ *
+ * @param[in] format The printf-style format string.
+ */
+void host_printf(const char *format, ...);
+
+/**
+ * @brief Gets the host's monotonic clock in nanoseconds.
+ *
+ * @return The clock value.
+ */
+uint64_t host_time_ns(void);
+
+/**
+ * @brief Determine if a benchmark has been selected on the command-line.
+ *
+ * @param[in] name The name of the benchmark.
+ *
+ * @return Non-zero if the benchmark should be run.
+ */
+int host_selected(const char *name);
+
+/**
+ * @brief Runs the benchmarks on the kernel side.
+ *
+ * @return Zero on success, non-zero if a benchmark failed.
+ */
+int bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
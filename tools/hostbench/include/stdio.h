@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef HOSTBENCH_STDIO_H
+#define HOSTBENCH_STDIO_H
+
+/* Only the parts of <stdio.h> that the kernel uses; see <string.h> */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void __putchar(char c);
+int printf(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
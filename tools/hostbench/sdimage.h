@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef HOSTBENCH_SDIMAGE_H
+#define HOSTBENCH_SDIMAGE_H
+
+/* Forced into "target/sim/spi.c" so that the emulated SD card is backed
+ * by the image file that was loaded by the host instead of the memory
+ * region that mos-sim loads the image into. */
+
+#include "host.h"
+
+#define sdemu_image hostbench_image
+#define sdemu_image_blocks hostbench_image_blocks
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+/*
+ * Stand-ins for the parts of the kernel that are not built on the host:
+ * the process table, the target's clock and console, and devices.
+ * The benchmarks run as a single process that is always in the kernel.
+ */
+
+#include <mosnix/proc.h>
+#include <mosnix/inode.h>
+#include <mosnix/file.h>
+#include <mosnix/devices.h>
+#include <mosnix/target.h>
+#include <errno.h>
+#include <string.h>
+#include "host.h"
+
+struct proc * volatile current_proc;
+uint8_t volatile in_kernel;
+
+static struct proc bench_proc;
+
+/**
+ * @brief Sets up the process that the benchmarks run as.
+ */
+void stubs_init(void)
+{
+    memset(&bench_proc, 0, sizeof(bench_proc));
+    bench_proc.pid = 1;
+    bench_proc.umask = 022;
+    strcpy(bench_proc.cwd, "/");
+    current_proc = &bench_proc;
+    in_kernel = 1;
+}
+
+unsigned short sys_clock(void)
+{
+    return (unsigned short)(host_time_ns() / (1000000000ULL / 256));
+}
+
+void sys_monoclock(long long *t)
+{
+    *t = (long long)(host_time_ns() / (1000000000ULL / 256));
+}
+
+int sem_wait(struct sem *sem)
+{
+    /* There is only one process, so the semaphore is always available */
+    --(sem->value);
+    return 0;
+}
+
+void sem_signal(struct sem *sem)
+{
+    ++(sem->value);
+}
+
+int timer_sleep(clock_t ticks, clock_t *left)
+{
+    /* Nothing else to run, so return immediately and let the caller
+     * poll the clock instead */
+    (void)ticks;
+    if (left)
+        *left = 0;
+    return 0;
+}
+
+time_t inode_get_mtime(void)
+{
+    return 0;
+}
+
+void __putchar(char c)
+{
+    host_printf("%c", c);
+}
+
+int char_device_open(dev_t dev, struct file *file)
+{
+    (void)dev;
+    (void)file;
+    return -ENODEV;
+}
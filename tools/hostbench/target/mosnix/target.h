@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2023 Rhys Weatherley
+ *
+ * Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+ * See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+ * information.
+ */
+
+#ifndef MOSNIX_TARGET_HOSTBENCH_H
+#define MOSNIX_TARGET_HOSTBENCH_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Name of the target for uname */
+#define CONFIG_TARGET_NAME "hostbench"
+
+/* Get the monotonic system clock in 1/256'ths of a second */
+extern void sys_monoclock(long long *t);
+
+/* Get the low 16 bits of the monotonic system clock */
+extern unsigned short sys_clock(void);
+
+/* The SD card is emulated on the SPI interface by "target/sim/spi.c" */
+#define CONFIG_SPI 1
+#define CONFIG_SD 1
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2023 Rhys Weatherley
+#
+# Licensed under the Apache License, Version 2.0 with LLVM Exceptions,
+# See https://github.com/rweater/mosnix/blob/main/LICENSE for license
+# information.
+#
+# Usage: mksdimage.py [options] output-file [source-directory]
+#
+# Builds a FAT32 SD card image from the contents of a host directory.
+#
+# The image is deliberately minimal so that it can be made small enough to
+# fit into the simulator's memory map.  The kernel's SD card driver only
+# checks the fields that it needs, so the number of clusters does not have
+# to meet the usual FAT32 minimum.
+
+import argparse
+import os
+import struct
+import sys
+
+BLKSIZE = 512
+RESERVED_BLOCKS = 2
+FAT_EOC = 0x0FFFFFFF
+
+def fat_name(name):
+    """Convert a host filename into a padded 8.3 FAT name."""
+    if name in ('.', '..'):
+        return name.ljust(11).encode('ascii')
+    base, dot, ext = name.upper().partition('.')
+    if not base or len(base) > 8 or len(ext) > 3 or '.' in ext:
+        raise ValueError('%s is not a valid 8.3 filename' % name)
+    return (base.ljust(8) + ext.ljust(3)).encode('ascii')
+
+def dir_entry(name, attrs, cluster, size):
+    return struct.pack('<11sBBBHHHHHHHI', fat_name(name), attrs, 0x18, 0,
+                       0, 0x21, 0x21, cluster >> 16, 0, 0x21,
+                       cluster & 0xFFFF, size)
+
+class Node:
+    def __init__(self, name, path, is_dir):
+        self.name = name
+        self.path = path
+        self.is_dir = is_dir
+        self.children = []
+        self.data = b''
+        self.clusters = []
+
+class Image:
+    def __init__(self, blocks, cluster_size, partition):
+        self.cluster_size = cluster_size
+        self.cluster_bytes = cluster_size * BLKSIZE
+        self.part_offset = 8 if partition else 0
+        self.partition = partition
+        self.blocks = blocks
+        part_blocks = blocks - self.part_offset
+        self.fat_size = 1
+        while True:
+            data_blocks = part_blocks - RESERVED_BLOCKS - 2 * self.fat_size
+            self.cluster_count = data_blocks // cluster_size
+            needed = ((self.cluster_count + 2) * 4 + BLKSIZE - 1) // BLKSIZE
+            if needed <= self.fat_size:
+                break
+            self.fat_size = needed
+        if self.cluster_count < 1:
+            raise ValueError('image is too small')
+        self.fat = [0x0FFFFFF8, FAT_EOC] + [0] * self.cluster_count
+        self.next_cluster = 2
+        self.data = {}
+
+    def alloc(self, count, stride=1):
+        """Allocate a chain of clusters, optionally leaving gaps."""
+        chain = []
+        cluster = self.next_cluster
+        for n in range(count):
+            while cluster < len(self.fat) and self.fat[cluster] != 0:
+                cluster += 1
+            if cluster >= len(self.fat):
+                raise ValueError('image is full')
+            chain.append(cluster)
+            self.fat[cluster] = FAT_EOC
+            cluster += stride
+        for prev, next in zip(chain, chain[1:]):
+            self.fat[prev] = next
+        return chain
+
+    def write_chain(self, chain, data):
+        for index, cluster in enumerate(chain):
+            self.data[cluster] = \
+                data[index * self.cluster_bytes:(index + 1) * self.cluster_bytes]
+
+def scan(path, name):
+    node = Node(name, path, True)
+    for entry in sorted(os.listdir(path)):
+        full = os.path.join(path, entry)
+        if os.path.isdir(full):
+            node.children.append(scan(full, entry))
+        else:
+            child = Node(entry, full, False)
+            with open(full, 'rb') as f:
+                child.data = f.read()
+            node.children.append(child)
+    return node
+
+def layout(image, node, parent_cluster, fragment):
+    # Allocate the clusters for the directory itself first.
+    entries = len(node.children) + (2 if parent_cluster is not None else 0) + 1
+    size = entries * 32
+    count = max(1, (size + image.cluster_bytes - 1) // image.cluster_bytes)
+    node.clusters = image.alloc(count)
+    my_cluster = node.clusters[0]
+    for child in node.children:
+        if child.is_dir:
+            layout(image, child, my_cluster, fragment)
+        elif child.data:
+            count = (len(child.data) + image.cluster_bytes - 1) // \
+                image.cluster_bytes
+            child.clusters = image.alloc(count, 2 if fragment else 1)
+            image.write_chain(child.clusters, child.data)
+    data = b''
+    if parent_cluster is not None:
+        data += dir_entry('.', 0x10, my_cluster, 0)
+        data += dir_entry('..', 0x10, parent_cluster, 0)
+    for child in node.children:
+        cluster = child.clusters[0] if child.clusters else 0
+        if child.is_dir:
+            data += dir_entry(child.name, 0x10, cluster, 0)
+        else:
+            data += dir_entry(child.name, 0x20, cluster, len(child.data))
+    image.write_chain(node.clusters, data)
+
+def build(image, root):
+    layout(image, root, None, args.fragment)
+    out = bytearray(image.blocks * BLKSIZE)
+    if image.partition:
+        mbr = bytearray(BLKSIZE)
+        mbr[446:462] = struct.pack('<B3sB3sII', 0, b'\0\0\0', 0x0C, b'\0\0\0',
+                                   image.part_offset,
+                                   image.blocks - image.part_offset)
+        mbr[510] = 0x55
+        mbr[511] = 0xAA
+        out[0:BLKSIZE] = mbr
+    pbr = bytearray(BLKSIZE)
+    pbr[0:3] = b'\xEB\x58\x90'
+    pbr[3:11] = b'MOSNIX  '
+    struct.pack_into('<HBHBHHBHHHII', pbr, 11, BLKSIZE, image.cluster_size,
+                     RESERVED_BLOCKS, 2, 0, 0, 0xF8, 0, 32, 2,
+                     image.part_offset, 0)
+    struct.pack_into('<IIHHIHH', pbr, 32, image.blocks - image.part_offset,
+                     image.fat_size, 0, 0, 2, 1, 0)
+    struct.pack_into('<BBBI11s8s', pbr, 64, 0x80, 0, 0x29, 0x4D4F534E,
+                     b'MOSNIX     ', b'FAT32   ')
+    pbr[510] = 0x55
+    pbr[511] = 0xAA
+    base = image.part_offset * BLKSIZE
+    out[base:base + BLKSIZE] = pbr
+    fsinfo = bytearray(BLKSIZE)
+    struct.pack_into('<I', fsinfo, 0, 0x41615252)
+    struct.pack_into('<III', fsinfo, 484, 0x61417272, 0xFFFFFFFF, 0xFFFFFFFF)
+    struct.pack_into('<I', fsinfo, 508, 0xAA550000)
+    out[base + BLKSIZE:base + 2 * BLKSIZE] = fsinfo
+    fat = b''.join(struct.pack('<I', entry) for entry in image.fat)
+    for copy in range(2):
+        start = base + (RESERVED_BLOCKS + copy * image.fat_size) * BLKSIZE
+        out[start:start + len(fat)] = fat
+    data_start = base + (RESERVED_BLOCKS + 2 * image.fat_size) * BLKSIZE
+    for cluster, data in image.data.items():
+        start = data_start + (cluster - 2) * image.cluster_bytes
+        out[start:start + len(data)] = data
+    return bytes(out)
+
+parser = argparse.ArgumentParser(description='Build a FAT32 SD card image')
+parser.add_argument('--blocks', type=int, default=64,
+                    help='size of the image in 512-byte blocks')
+parser.add_argument('--cluster-size', type=int, default=1,
+                    choices=[1, 2, 4, 8, 16, 32, 64, 128],
+                    help='number of blocks in each cluster')
+parser.add_argument('--partition', action='store_true',
+                    help='add a partition table to the image')
+parser.add_argument('--fragment', action='store_true',
+                    help='leave gaps between the clusters of each file')
+parser.add_argument('--pattern', action='append', default=[],
+                    metavar='PATH:SIZE',
+                    help='add a file of SIZE bytes with a repeating pattern')
+parser.add_argument('--load-address', type=lambda x: int(x, 0),
+                    help='add a simulator load header for this address')
+parser.add_argument('output', help='output image file')
+parser.add_argument('source', nargs='?', help='directory to copy files from')
+args = parser.parse_args()
+
+if args.source:
+    root = scan(args.source, '')
+else:
+    root = Node('', '', True)
+for pattern in args.pattern:
+    path, _, size = pattern.partition(':')
+    parent = root
+    *dirs, name = path.split('/')
+    for dir in dirs:
+        node = next((c for c in parent.children if c.name == dir), None)
+        if node is None:
+            node = Node(dir, '', True)
+            parent.children.append(node)
+        parent = node
+    child = Node(name, '', False)
+    child.data = bytes((n * 7 + (n >> 8)) & 0xFF for n in range(int(size, 0)))
+    parent.children.append(child)
+try:
+    data = build(Image(args.blocks, args.cluster_size, args.partition), root)
+except ValueError as e:
+    print('mksdimage: ' + str(e), file=sys.stderr)
+    sys.exit(1)
+with open(args.output, 'wb') as f:
+    if args.load_address is not None:
+        f.write(struct.pack('<HH', args.load_address, len(data)))
+    f.write(data)